@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "../include/VLSI.h"
+#include "../include/bookshelf.h"
+#include "../include/fm.h"
+#include "../include/generator.h"
+#include "../include/utility.h"
+
+// ## benchmark suite of the partitioning phases
+// every phase runs --repeat times on every design: synthetic Bookshelf designs of several sizes, written to --work-dir,
+// the designs given with --aux, and every datasets/*/*.aux found on disk
+// the results are printed, written as JSON with --json, and compared with a previous JSON with --baseline:
+// a phase whose median time grew by more than --tolerance is a regression, and the exit code is 1
+
+// ## timings of one phase on one design
+struct PhaseResult {
+public:
+    std::string design;
+    std::string phase;
+    std::vector<double> times_ms;
+    double work; // pins, moves or operations done by one run
+    std::string unit;
+    double percentile(double p) const {
+        std::vector<double> sorted = times_ms;
+        std::sort(sorted.begin(), sorted.end());
+        // nearest rank
+        int rank = static_cast<int>(std::ceil(p / 100 * sorted.size()));
+        return sorted[std::min(std::max(rank, 1), static_cast<int>(sorted.size())) - 1];
+    }
+    double median() const { return percentile(50); }
+    double throughput() const { return median() > 0 ? work / (median() / 1000) : 0; }
+};
+
+long peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+double elapsed_ms(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// ## write a synthetic Bookshelf design with as many nets as nodes and 10% terminals
+std::string write_synthetic_design(const std::string& work_dir, int num_nodes, unsigned seed) {
+    std::string name = "synthetic" + std::to_string(num_nodes);
+    std::string aux = work_dir + "/" + name + ".aux";
+    GeneratorOptions options;
+    options.num_nodes = num_nodes;
+    options.num_nets = num_nodes;
+    options.terminal_fraction = 0.1;
+    options.seed = seed;
+    if (!generate_bookshelf(aux, options)) {
+        exit(1);
+    }
+    return aux;
+}
+
+// every datasets/<design>/<design>.aux
+std::vector<std::string> find_designs_on_disk(const std::string& datasets_dir) {
+    std::vector<std::string> designs;
+    DIR* dir = opendir(datasets_dir.c_str());
+    if (dir == nullptr) {
+        return designs;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        std::string aux = datasets_dir + "/" + name + "/" + name + ".aux";
+        struct stat info;
+        if (name != "." && name != ".." && stat(aux.c_str(), &info) == 0) {
+            designs.push_back(aux);
+        }
+    }
+    closedir(dir);
+    std::sort(designs.begin(), designs.end());
+    return designs;
+}
+
+std::string design_name(const std::string& aux) {
+    size_t slash = aux.find_last_of('/');
+    std::string name = slash == std::string::npos ? aux : aux.substr(slash + 1);
+    return name.substr(0, name.rfind(".aux"));
+}
+
+// random balanced initial partition, the same for every repetition
+std::vector<int> initial_partition(const Hypergraph& graph, unsigned seed) {
+    std::vector<int> order(graph.num_nodes());
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 rng(seed);
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<int> partition(graph.num_nodes(), 0);
+    double part_size[2] = {0, 0};
+    for (int node : order) {
+        int part = part_size[0] <= part_size[1] ? 0 : 1;
+        partition[node] = part;
+        part_size[part] += graph.node_size[node];
+    }
+    return partition;
+}
+
+void bench_design(const std::string& aux, int repeat, std::vector<PhaseResult>& results) {
+    std::string name = design_name(aux);
+    BookshelfFiles files = read_bookshelf_aux(aux);
+    PhaseResult parse_nodes{name, "parse_nodes", {}, 0, "nodes/s"};
+    PhaseResult parse_nets{name, "parse_nets", {}, 0, "pins/s"};
+    PhaseResult gain_init{name, "fm_gain_init", {}, 0, "pins/s"};
+    PhaseResult main_loop{name, "fm_main_loop", {}, 0, "moves/s"};
+    PhaseResult bucket_ops{name, "bucket_ops", {}, 0, "ops/s"};
+    PhaseResult materialize{name, "materialize", {}, 0, "pins/s"};
+
+    Hypergraph graph;
+    for (int r = 0; r < repeat; r++) {
+        Hypergraph nodes_only;
+        auto start = std::chrono::high_resolution_clock::now();
+        load_bookshelf_nodes(files.nodes, nodes_only);
+        parse_nodes.times_ms.push_back(elapsed_ms(start));
+        parse_nodes.work = nodes_only.num_nodes();
+
+        start = std::chrono::high_resolution_clock::now();
+        load_bookshelf_nets(files.nets, nodes_only);
+        parse_nets.times_ms.push_back(elapsed_ms(start));
+        parse_nets.work = nodes_only.num_pins();
+        graph = std::move(nodes_only);
+    }
+    std::cout << name << ": " << graph.num_nodes() << " nodes, " << graph.num_nets() << " nets, " << graph.num_pins() << " pins" << std::endl;
+
+    // one FM pass from the same start every time
+    FMOptions options;
+    options.max_passes = 1;
+    options.dump_level = -1;
+    std::vector<int> start_partition = initial_partition(graph, 13);
+    std::vector<int> partition;
+    for (int r = 0; r < repeat; r++) {
+        partition = start_partition;
+        FMBipartitioner bipartitioner(graph, options);
+        bipartitioner.run(partition);
+        const FMPassStats& pass = bipartitioner.pass_stats().front();
+        gain_init.times_ms.push_back(pass.gain_init_ms);
+        gain_init.work = graph.num_pins();
+        main_loop.times_ms.push_back(pass.time_ms - pass.gain_init_ms);
+        main_loop.work = pass.moves;
+    }
+
+    // FM-like bucket traffic: fill, then pop the max gain node and update the gains of a few others, until empty
+    int max_degree = 0;
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        max_degree = std::max(max_degree, graph.nets_of(node).size());
+    }
+    for (int r = 0; r < repeat; r++) {
+        std::mt19937 rng(13);
+        BucketArray bucket;
+        long long ops = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        bucket.reset(max_degree, graph.num_nodes());
+        for (int node = 0; node < graph.num_nodes(); node++) {
+            bucket.insert(node, static_cast<int>(rng() % (2 * max_degree + 1)) - max_degree);
+        }
+        ops += graph.num_nodes();
+        while (!bucket.is_empty()) {
+            bucket.erase(bucket.get_max_gain_node());
+            for (int u = 0; u < 4; u++) {
+                int node = rng() % graph.num_nodes();
+                if (bucket.contains(node)) {
+                    int gain = bucket.gain(node);
+                    bucket.update_gain(node, gain < max_degree && (rng() & 1) ? gain + 1 : std::max(gain - 1, -max_degree));
+                    ops++;
+                }
+            }
+            ops++;
+        }
+        bucket_ops.times_ms.push_back(elapsed_ms(start));
+        bucket_ops.work = static_cast<double>(ops);
+    }
+
+    Circuit circuit{Hypergraph(graph)};
+    for (int r = 0; r < repeat; r++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        CircuitPartition result(circuit, partition);
+        Circuit part0 = result.sub_circuit(0);
+        Circuit part1 = result.sub_circuit(1);
+        materialize.times_ms.push_back(elapsed_ms(start));
+        materialize.work = part0.hypergraph().num_pins() + part1.hypergraph().num_pins();
+    }
+
+    for (PhaseResult* result : {&parse_nodes, &parse_nets, &gain_init, &main_loop, &bucket_ops, &materialize}) {
+        results.push_back(*result);
+    }
+}
+
+std::string to_json(const std::vector<PhaseResult>& results, int repeat) {
+    std::ostringstream json;
+    json << "{\n  \"repeat\": " << repeat << ",\n  \"peak_rss_kb\": " << peak_rss_kb() << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const PhaseResult& r = results[i];
+        // one result per line, read back by load_baseline
+        json << "    {\"design\": \"" << r.design << "\", \"phase\": \"" << r.phase << "\", \"median_ms\": " << r.median() << ", \"p10_ms\": " << r.percentile(10) << ", \"p90_ms\": " << r.percentile(90)
+             << ", \"min_ms\": " << r.percentile(0) << ", \"max_ms\": " << r.percentile(100) << ", \"throughput\": " << r.throughput() << ", \"unit\": \"" << r.unit << "\"}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+// value of "key": in a line of the JSON written by to_json
+std::string json_field(const std::string& line, const std::string& key) {
+    size_t pos = line.find("\"" + key + "\": ");
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos += key.size() + 4;
+    if (line[pos] == '"') {
+        return line.substr(pos + 1, line.find('"', pos + 1) - pos - 1);
+    }
+    return line.substr(pos, line.find_first_of(",}", pos) - pos);
+}
+
+// design/phase -> median_ms of a JSON written by to_json
+std::map<std::string, double> load_baseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string design = json_field(line, "design");
+        std::string median = json_field(line, "median_ms");
+        if (!design.empty() && !median.empty()) {
+            baseline[design + "/" + json_field(line, "phase")] = std::stod(median);
+        }
+    }
+    return baseline;
+}
+
+int main(int argc, char* argv[]) {
+    int repeat = 5;
+    std::vector<int> sizes = {10000, 100000};
+    std::vector<std::string> designs;
+    std::string work_dir = "bench/data";
+    std::string datasets_dir = "datasets";
+    std::string json_file = "";
+    std::string baseline_file = "";
+    double tolerance = 0.1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--repeat") {
+            repeat = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--sizes") {
+            // comma separated node counts, empty for no synthetic design
+            sizes.clear();
+            std::stringstream list(argv[++i]);
+            std::string size;
+            while (std::getline(list, size, ',')) {
+                sizes.push_back(std::stoi(size));
+            }
+        }
+        else if (arg == "--aux") {
+            designs.push_back(argv[++i]);
+        }
+        else if (arg == "--work-dir") {
+            work_dir = argv[++i];
+        }
+        else if (arg == "--datasets") {
+            datasets_dir = argv[++i];
+        }
+        else if (arg == "--json") {
+            json_file = argv[++i];
+        }
+        else if (arg == "--baseline") {
+            baseline_file = argv[++i];
+        }
+        else if (arg == "--tolerance") {
+            tolerance = std::stod(argv[++i]);
+        }
+        else if (arg == "--help" || arg == "-h") {
+            std::cout << "Usage: " << argv[0] << " [--repeat <n>] [--sizes <n,n,...>] [--aux <file>]... [--work-dir <dir>] [--datasets <dir>] [--json <file>] [--baseline <file>] [--tolerance <fraction>]" << std::endl;
+            std::cout << "  --repeat <n> : runs of every phase (5)" << std::endl;
+            std::cout << "  --sizes <n,n,...> : node counts of the synthetic designs (10000,100000)" << std::endl;
+            std::cout << "  --aux <file> : also run this Bookshelf design, may be repeated" << std::endl;
+            std::cout << "  --work-dir <dir> : where the synthetic designs are written (bench/data)" << std::endl;
+            std::cout << "  --datasets <dir> : also run every <dir>/<design>/<design>.aux (datasets)" << std::endl;
+            std::cout << "  --json <file> : write the results as JSON" << std::endl;
+            std::cout << "  --baseline <file> : compare the median times with this JSON, exit with 1 on a regression" << std::endl;
+            std::cout << "  --tolerance <fraction> : slowdown of a median time that counts as a regression (0.1)" << std::endl;
+            return 0;
+        }
+    }
+
+    std::vector<std::string> all_designs;
+    if (!sizes.empty()) {
+        mkdir(work_dir.c_str(), 0755);
+    }
+    for (int size : sizes) {
+        all_designs.push_back(write_synthetic_design(work_dir, size, 13));
+    }
+    for (const std::string& design : find_designs_on_disk(datasets_dir)) {
+        all_designs.push_back(design);
+    }
+    all_designs.insert(all_designs.end(), designs.begin(), designs.end());
+
+    std::vector<PhaseResult> results;
+    for (const std::string& design : all_designs) {
+        bench_design(design, repeat, results);
+    }
+
+    std::map<std::string, double> baseline;
+    if (!baseline_file.empty()) {
+        baseline = load_baseline(baseline_file);
+        if (baseline.empty()) {
+            std::cout << "No baseline results in " << baseline_file << std::endl;
+        }
+    }
+    int regressions = 0;
+    printf("%-20s %-14s %10s %10s %10s %14s %-8s %s\n", "design", "phase", "median ms", "p10 ms", "p90 ms", "throughput", "unit", baseline.empty() ? "" : "vs baseline");
+    for (const PhaseResult& r : results) {
+        std::string comparison;
+        auto it = baseline.find(r.design + "/" + r.phase);
+        if (it != baseline.end() && it->second > 0) {
+            double change = r.median() / it->second - 1;
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "%+.1f%%", 100 * change);
+            comparison = buffer;
+            if (change > tolerance) {
+                comparison += " REGRESSION";
+                regressions++;
+            }
+        }
+        printf("%-20s %-14s %10.2f %10.2f %10.2f %14.4g %-8s %s\n", r.design.c_str(), r.phase.c_str(), r.median(), r.percentile(10), r.percentile(90), r.throughput(), r.unit.c_str(), comparison.c_str());
+    }
+    std::cout << "Peak RSS: " << peak_rss_kb() << " KB" << std::endl;
+
+    if (!json_file.empty()) {
+        std::ofstream json(json_file);
+        json << to_json(results, repeat);
+        if (!json) {
+            std::cerr << "Error: cannot write " << json_file << std::endl;
+            return 1;
+        }
+    }
+    if (regressions > 0) {
+        std::cout << regressions << " phases slower than the baseline by more than " << 100 * tolerance << "%" << std::endl;
+        return 1;
+    }
+    return 0;
+}
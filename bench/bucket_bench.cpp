@@ -0,0 +1,175 @@
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/utility.h"
+
+// ## microbenchmark: Bucket (hash map of lists) vs BucketArray (array of intrusive lists)
+// a FM-like update stream is generated once, then replayed on both structures:
+// insert every node, then repeatedly pop the max gain node and apply random +-1 gain updates
+// to other free nodes, like the gain updates on the nets of a moved node
+
+enum class BucketOp {
+    pop, // get the max gain node and erase it, id is the expected node
+    increase,
+    decrease
+};
+
+struct StreamEntry {
+public:
+    BucketOp op;
+    int id;
+};
+
+struct UpdateStream {
+public:
+    int num_nodes;
+    int max_possible_gain;
+    std::vector<int> initial_gains;
+    std::vector<StreamEntry> entries;
+    long long num_updates;
+};
+
+// build the stream, BucketArray serves as the reference to know which node is popped
+UpdateStream generate_stream(int num_nodes, int max_possible_gain, int updates_per_move, int num_moves, unsigned seed) {
+    UpdateStream stream;
+    stream.num_nodes = num_nodes;
+    stream.max_possible_gain = max_possible_gain;
+    stream.num_updates = 0;
+    std::mt19937 rng(seed);
+    // most nodes have a small degree, gains start in [-degree, degree]
+    std::uniform_int_distribution<int> initial_gain(-3, 3);
+    BucketArray reference(max_possible_gain, num_nodes);
+    std::vector<int> free_nodes(num_nodes);
+    std::vector<int> position(num_nodes);
+    stream.initial_gains.resize(num_nodes);
+    for (int id = 0; id < num_nodes; id++) {
+        stream.initial_gains[id] = initial_gain(rng);
+        reference.insert(id, stream.initial_gains[id]);
+        free_nodes[id] = id;
+        position[id] = id;
+    }
+    stream.entries.reserve(static_cast<size_t>(num_moves) * (updates_per_move + 1));
+    for (int move = 0; move < num_moves && !free_nodes.empty(); move++) {
+        int id = reference.get_max_gain_node();
+        reference.erase(id);
+        stream.entries.push_back({BucketOp::pop, id});
+        // remove the popped node from the free list
+        int last = free_nodes.back();
+        free_nodes[position[id]] = last;
+        position[last] = position[id];
+        free_nodes.pop_back();
+        for (int u = 0; u < updates_per_move && !free_nodes.empty(); u++) {
+            int target = free_nodes[rng() % free_nodes.size()];
+            bool increase = rng() % 2 == 0;
+            // keep the gain in [-pmax, pmax]
+            if (reference.gain(target) >= max_possible_gain) {
+                increase = false;
+            }
+            else if (reference.gain(target) <= -max_possible_gain) {
+                increase = true;
+            }
+            if (increase) {
+                reference.increase_gain(target);
+            }
+            else {
+                reference.decrease_gain(target);
+            }
+            stream.entries.push_back({increase ? BucketOp::increase : BucketOp::decrease, target});
+            stream.num_updates++;
+        }
+    }
+    return stream;
+}
+
+// replay the stream, return the time in ms, exit on a popped node different from the reference
+template <typename BucketType, typename Init, typename MaxNode>
+double replay(const UpdateStream& stream, BucketType& bucket, Init insert, MaxNode max_gain_node, const std::string& name) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int id = 0; id < stream.num_nodes; id++) {
+        insert(bucket, id, stream.initial_gains[id]);
+    }
+    for (const auto& entry : stream.entries) {
+        if (entry.op == BucketOp::pop) {
+            int id = max_gain_node(bucket);
+            if (id != entry.id) {
+                std::cerr << "Error: " << name << " popped node " << id << ", expected " << entry.id << std::endl;
+                exit(1);
+            }
+            bucket.erase(id);
+        }
+        else if (entry.op == BucketOp::increase) {
+            bucket.increase_gain(entry.id);
+        }
+        else {
+            bucket.decrease_gain(entry.id);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    // superblue1 sized defaults
+    int num_nodes = 847441;
+    int max_possible_gain = 64;
+    int updates_per_move = 12;
+    int num_moves = -1;
+    unsigned seed = 13;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--nodes") {
+            num_nodes = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--pmax") {
+            max_possible_gain = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--updates") {
+            updates_per_move = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--moves") {
+            num_moves = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--seed") {
+            seed = static_cast<unsigned>(std::stoul(argv[i + 1]));
+            i++;
+        }
+        else if (std::string(argv[i]) == "--help" || std::string(argv[i]) == "-h") {
+            std::cout << "Usage: " << argv[0] << " [--nodes <n>] [--pmax <p>] [--updates <u>] [--moves <m>] [--seed <s>]" << std::endl;
+            std::cout << "  --nodes <n> : number of nodes in the buckets (847441)" << std::endl;
+            std::cout << "  --pmax <p> : maximum possible gain (64)" << std::endl;
+            std::cout << "  --updates <u> : gain updates after every move (12)" << std::endl;
+            std::cout << "  --moves <m> : number of moves, defaults to the number of nodes" << std::endl;
+            std::cout << "  --seed <s> : seed of the update stream (13)" << std::endl;
+            return 0;
+        }
+    }
+    if (num_moves < 0) {
+        num_moves = num_nodes;
+    }
+
+    UpdateStream stream = generate_stream(num_nodes, max_possible_gain, updates_per_move, num_moves, seed);
+    long long num_ops = num_nodes + static_cast<long long>(stream.entries.size());
+    std::cout << "Stream: " << num_nodes << " nodes, " << num_moves << " moves, " << stream.num_updates << " gain updates, pmax " << max_possible_gain << std::endl;
+
+    Bucket bucket(max_possible_gain);
+    double bucket_ms = replay(stream, bucket,
+        [](Bucket& b, int id, int gain) { b.insert(id, gain, 1.0); },
+        [](Bucket& b) { return b.get_max_gain_node().id; }, "Bucket");
+
+    BucketArray bucket_array(max_possible_gain, num_nodes);
+    double bucket_array_ms = replay(stream, bucket_array,
+        [](BucketArray& b, int id, int gain) { b.insert(id, gain); },
+        [](BucketArray& b) { return b.get_max_gain_node(); }, "BucketArray");
+
+    std::cout << "Bucket: " << bucket_ms << " ms, " << num_ops / bucket_ms / 1e3 << " Mops/s" << std::endl;
+    std::cout << "BucketArray: " << bucket_array_ms << " ms, " << num_ops / bucket_array_ms / 1e3 << " Mops/s" << std::endl;
+    std::cout << "Speedup: " << bucket_ms / bucket_array_ms << "x" << std::endl;
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "include/generator.h"
+
+// write a synthetic Bookshelf design, e.g. "--nodes 1000000 --nets 1000000 --out datasets/synthetic1m/synthetic1m.aux"
+int main(int argc, char* argv[]) {
+    GeneratorOptions options;
+    std::string aux_file_dir = "datasets/synthetic/synthetic.aux";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            std::cout << "Usage: " << argv[0] << " [--out <aux_file_dir>] [--nodes <n>] [--nets <n>] [--pins <n>] [--exponent <a>] [--max-degree <n>] [--terminals <fraction>] [--macros <fraction>] [--macro-scale <area>] [--row-height <h>] [--locality <p>] [--window <n>] [--utilization <fraction>] [--seed <n>]" << std::endl;
+            std::cout << "  --out <aux_file_dir> : the .aux file to write, the other files go next to it (datasets/synthetic/synthetic.aux)" << std::endl;
+            std::cout << "  --nodes <n> : number of nodes, terminals included (10000)" << std::endl;
+            std::cout << "  --nets <n> : number of nets (10000)" << std::endl;
+            std::cout << "  --pins <n> : exact number of pins, 0 for the mean of the degree distribution (0)" << std::endl;
+            std::cout << "  --exponent <a> : net degrees follow P(d) ~ d^-a from 2 on, tuned to meet --pins (2.5)" << std::endl;
+            std::cout << "  --max-degree <n> : maximum net degree (1000)" << std::endl;
+            std::cout << "  --terminals <fraction> : fraction of terminal nodes (0.05)" << std::endl;
+            std::cout << "  --macros <fraction> : probability of a movable node to be a macro (0.001)" << std::endl;
+            std::cout << "  --macro-scale <area> : mean macro area in mean standard cell areas (500)" << std::endl;
+            std::cout << "  --row-height <h> : standard cell and row height (9)" << std::endl;
+            std::cout << "  --locality <p> : probability of a pin to be near its net in node order (0.9)" << std::endl;
+            std::cout << "  --window <n> : a near pin is within max(n, net degree) node ids of the net center (50)" << std::endl;
+            std::cout << "  --utilization <fraction> : movable area over row area in the .scl file (0.7)" << std::endl;
+            std::cout << "  --seed <n> : the design only depends on the options and the seed (13)" << std::endl;
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: missing value of " << arg << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--out") {
+            aux_file_dir = value;
+        }
+        else if (arg == "--nodes") {
+            options.num_nodes = std::stoi(value);
+        }
+        else if (arg == "--nets") {
+            options.num_nets = std::stoi(value);
+        }
+        else if (arg == "--pins") {
+            options.num_pins = std::stoll(value);
+        }
+        else if (arg == "--exponent") {
+            options.degree_exponent = std::stod(value);
+        }
+        else if (arg == "--max-degree") {
+            options.max_net_degree = std::stoi(value);
+        }
+        else if (arg == "--terminals") {
+            options.terminal_fraction = std::stod(value);
+        }
+        else if (arg == "--macros") {
+            options.macro_fraction = std::stod(value);
+        }
+        else if (arg == "--macro-scale") {
+            options.macro_scale = std::stod(value);
+        }
+        else if (arg == "--row-height") {
+            options.row_height = std::stod(value);
+        }
+        else if (arg == "--locality") {
+            options.locality = std::stod(value);
+        }
+        else if (arg == "--window") {
+            options.locality_window = std::stoi(value);
+        }
+        else if (arg == "--utilization") {
+            options.utilization = std::stod(value);
+        }
+        else if (arg == "--seed") {
+            options.seed = std::stoul(value);
+        }
+        else {
+            std::cerr << "Error: unknown option " << arg << ", see --help" << std::endl;
+            return 1;
+        }
+    }
+
+    std::filesystem::path directory = std::filesystem::path(aux_file_dir).parent_path();
+    std::error_code error;
+    if (!directory.empty() && !std::filesystem::create_directories(directory, error) && error) {
+        std::cerr << "Error: cannot create directory " << directory.string() << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    GeneratorStats stats;
+    if (!generate_bookshelf(aux_file_dir, options, &stats)) {
+        return 1;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Generated " << aux_file_dir << ": " << stats.num_nodes << " nodes, " << stats.num_terminals << " terminals, " << stats.num_macros << " macros, " << stats.num_nets << " nets, " << stats.num_pins << " pins, max net degree " << stats.max_net_degree << std::endl;
+    std::cout << "Time to generate: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+    return 0;
+}
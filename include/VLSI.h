@@ -6,14 +6,18 @@
 #include <unordered_map>
 #include <iostream>
 #include <string>
-#include <tuple>
 
-enum class NodeTypeEnum{
-    node,
-    terminal,
-    terminal_nl
-};
+#include "annealing.h"
+#include "eco.h"
+#include "fm.h"
+#include "hmetis.h"
+#include "hypergraph.h"
+#include "kway.h"
+#include "multilevel.h"
+#include "multistart.h"
+#include "quadratic.h"
 
+// ## node, pin and net records, materialized from the hypergraph at I/O time only
 struct CircuitNode {
 public:
     std::string name;
@@ -21,7 +25,6 @@ public:
     double height;
     double size;
     NodeTypeEnum node_type;
-    std::set<std::string> net_names_unique; // Some nets contains multiple pins from the same node
     CircuitNode();
     CircuitNode(std::string name, double width, double height, NodeTypeEnum node_type = NodeTypeEnum::node);
 };
@@ -39,21 +42,106 @@ struct CircuitNet {
 public:
     std::string name;
     std::vector<NodePin> node_pins; // all pins in this net
-    std::set<std::string> node_names_unique; // Some nets contains multiple pins from the same node
     CircuitNet();
     CircuitNet(std::string name);
 };
 
+class CircuitPartition;
+
 class Circuit {
 private:
-    std::unordered_map<std::string, CircuitNode> nodes; // node_name -> CircuitNode
-    std::unordered_map<std::string, CircuitNet> nets; // net_name -> CircuitNet
+    Hypergraph graph; // nodes and nets with dense integer ids, names only kept in its name tables
 public:
     Circuit();
+    Circuit(Hypergraph graph);
     void load_nodes(std::string nodes_file_dir);
-    void load_nets(std::string nets_file_dir);
-    void load(std::string aux_file_dir, int dump_level = 0);
-    std::tuple<Circuit, Circuit, std::vector<CircuitNet> > Fiduccia_Mattheyses_bipartition(int area_constraint, int max_unbalanced_nodes, int dump_level);
-    // void Timber_Wolf_placement();
+    void load_nets(std::string nets_file_dir, int num_threads = 0);
+    // ## load a Bookshelf design, or an hMETIS .hgr file, see load_hmetis
+    // if use_snapshot, a valid <aux basename>.hgsnap newer than the .aux, .nodes and .nets files is loaded instead
+    // the load phases go to metrics if it is not nullptr; num_threads parses the nets or the .hgr file, 0 for one per hardware thread
+    void load(std::string aux_file_dir, int dump_level = 0, bool use_snapshot = true, Metrics* metrics = nullptr, int num_threads = 0);
+    // ## load an hMETIS .hgr file, see include/hmetis.h, the net weights are dropped since the engines count cut nets
+    // if use_snapshot, a valid <hgr basename>.hgsnap newer than the .hgr file is loaded instead
+    void load_hmetis(std::string hgr_file_dir, int dump_level = 0, bool use_snapshot = true, Metrics* metrics = nullptr, int num_threads = 0);
+    // ## load and save binary hypergraph snapshots, print an error and return false on failure
+    bool load_snapshot(std::string snapshot_file_dir, int dump_level = 0, Metrics* metrics = nullptr);
+    bool save_snapshot(std::string snapshot_file_dir) const;
+    const Hypergraph& hypergraph() const;
+    CircuitNode node(int id) const;
+    CircuitNet net(int id) const;
+    // ## bipartitions, the results refer to this circuit
+    CircuitPartition Fiduccia_Mattheyses_bipartition(int area_constraint, int max_unbalanced_nodes, int dump_level);
+    CircuitPartition Fiduccia_Mattheyses_bipartition(const FMOptions& options);
+    CircuitPartition multilevel_bipartition(const MultilevelOptions& options);
+    // ## FM passes from an existing partition, e.g. of a previous run or a partition file
+    CircuitPartition warm_start_bipartition(std::vector<int> partition, const FMOptions& options);
+    // ## apply an ECO to this circuit and repartition incrementally, see include/eco.h
+    // the partition of the circuit before the ECO is carried over, then only the region around the change is refined
+    // print an error and leave the circuit unchanged if the ECO names unknown nodes or nets
+    bool apply_eco(const NetlistECO& eco, const std::vector<int>& partition, const ECOOptions& options, CircuitPartition& result);
+    // ## best of several FM starts run in parallel, see include/multistart.h
+    CircuitPartition multi_start_bipartition(const MultiStartOptions& options);
+    // ## k-way partition by parallel recursive bisection, see include/kway.h
+    KWayResult kway_partition(const KWayOptions& options) const;
+    // ## TimberWolf style simulated annealing placement, see include/annealing.h
+    // placement holds the rows and the starting positions, e.g. from load_bookshelf_placement, and gets the result
+    AnnealingResult Timber_Wolf_placement(Placement& placement, const AnnealingOptions& options) const;
+    // ## global placement by quadratic wirelength minimization and min-cut spreading, see include/quadratic.h
+    // the positions it gives are not legal, they seed Timber_Wolf_placement
+    QuadraticResult quadratic_placement(Placement& placement, const QuadraticOptions& options) const;
     void dump(int level = 0) const;
-};
\ No newline at end of file
+};
+
+// ## one part of a partition, viewed in the parent hypergraph without copying it
+// names, sizes, pin offsets and the nets of every node are read from the parent, the view only stores the ids of the part:
+// every net of a node of the part has a pin in the part, so the nets of a node are its parent nets, and the pins of a net
+// are trimmed to the pins in the part
+// the ids in and out of the view are parent ids, the view refers to the parent hypergraph, which must outlive it
+class PartView {
+private:
+    const Hypergraph* graph;
+    std::vector<int> part_nodes; // nodes of the part, in increasing order
+    std::vector<int> part_nets; // nets with pins in the part, in increasing order
+    std::vector<int> net_pin_offsets; // i -> the pins of part_nets[i] in the part at part_pins[net_pin_offsets[i], net_pin_offsets[i + 1])
+    std::vector<int> part_pins; // pin ids of the parent, they index its pin_node, pin_delta_width and pin_delta_height
+public:
+    PartView(const Hypergraph& graph, const std::vector<int>& assignment, int part);
+    const Hypergraph& parent() const { return *graph; }
+    int num_nodes() const { return static_cast<int>(part_nodes.size()); }
+    int num_nets() const { return static_cast<int>(part_nets.size()); }
+    int num_pins() const { return static_cast<int>(part_pins.size()); }
+    const std::vector<int>& nodes() const { return part_nodes; }
+    const std::vector<int>& nets() const { return part_nets; }
+    // pin ids of the i-th net of the view
+    IdRange pins_of(int i) const { return {part_pins.data() + net_pin_offsets[i], part_pins.data() + net_pin_offsets[i + 1]}; }
+    // nets of a node of the part
+    IdRange nets_of(int node) const { return graph->nets_of(node); }
+    // ## same dump as the Circuit of the part, see Circuit::dump
+    void dump(int level) const;
+};
+
+// ## result of a partition: the part of every node and the ids of the cut nets
+// the parts are only materialized on demand, the result refers to the parent circuit, which must outlive it
+class CircuitPartition {
+private:
+    const Circuit* parent;
+    int parts;
+    std::vector<int> assignment; // node id -> part
+    std::vector<int> cut_net_ids; // nets with nodes in more than one part, in increasing order
+public:
+    CircuitPartition();
+    CircuitPartition(const Circuit& parent, std::vector<int> partition, int num_parts = 2);
+    int num_parts() const { return parts; }
+    const std::vector<int>& partition() const { return assignment; }
+    const std::vector<int>& cut_nets() const { return cut_net_ids; }
+    int cut_size() const { return static_cast<int>(cut_net_ids.size()); }
+    // ## sub circuit of one part, built from the parent hypergraph
+    // only the nodes of the part and the pins that fall into it are copied, a net exists in the part if it has pins there,
+    // so the nets of every node are trimmed to the nets of the part
+    // use it when the part must own its data, e.g. to partition it again; view() reads a part without the copy
+    Circuit sub_circuit(int part) const;
+    // ## view of one part in the parent hypergraph, see PartView, it refers to the parent circuit
+    PartView view(int part) const;
+    // ## CircuitNet records of the cut nets, with all their pins
+    std::vector<CircuitNet> cut() const;
+};
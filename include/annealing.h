@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "hypergraph.h"
+#include "metrics.h"
+#include "placement.h"
+
+// ## options of the simulated annealing placer
+struct AnnealingOptions {
+public:
+    double moves_per_node; // moves tried at every temperature, per movable node
+    double initial_acceptance; // probability to accept the mean uphill move at the first temperature
+    double cooling; // the temperature is multiplied by this after every temperature
+    double min_acceptance; // stop once a temperature accepts less than this fraction of its moves
+    int max_temperatures;
+    double swap_probability; // probability to swap with a node of the target bin, if it has one, instead of moving there
+    double bin_width; // width of the density bins in mean movable node widths, the bins are one row high
+    double density_weight; // cost of one mean movable node area of bin overflow, in mean movable node widths of wirelength, 0 ignores the overlaps
+    bool legalize; // pack the nodes on the row sites after annealing
+    unsigned seed;
+    int dump_level; // 0 for one line per temperature, -1 for no dump
+    Metrics* metrics; // phases and samples of the run, nullptr to disable, not owned
+    AnnealingOptions();
+};
+
+// ## result of an annealing run
+struct AnnealingResult {
+public:
+    double initial_hpwl;
+    double annealed_hpwl; // before legalization
+    double hpwl; // final
+    int temperatures;
+    long long moves;
+    long long accepted;
+    int unplaced_nodes; // nodes the legalization found no free sites for, they keep their annealed position
+    double anneal_ms;
+    double legalize_ms;
+    double moves_per_second;
+};
+
+// ## TimberWolf style simulated annealing placement on the rows of a Placement
+// the movable nodes are the nodes that are not fixed and fit in a row, the others stay where they are and block the sites they cover
+// a move displaces a node to a random position of a window around it, or swaps it with a node there; the window shrinks and grows
+// to keep the acceptance near 0.44; the cost is the half perimeter wirelength plus the weighted overflow of density bins
+// the bounding box of every net is cached with the number of pins on each of its sides, a move only updates the boxes of the
+// nets of the moved nodes, and only rescans the pins of a net when the last pin on one side of its box moves inward
+class AnnealingPlacer {
+private:
+    // bounding box of the pins of a net, and how many pins lie on each side
+    struct NetBox {
+    public:
+        double x_min;
+        double x_max;
+        double y_min;
+        double y_max;
+        int num_x_min;
+        int num_x_max;
+        int num_y_min;
+        int num_y_max;
+        double hpwl() const { return (x_max - x_min) + (y_max - y_min); }
+    };
+    // a node moved by the move under evaluation
+    struct MovedNode {
+    public:
+        int node;
+        double old_x;
+        double old_y;
+        int old_row;
+        int old_bin;
+        int new_row;
+        int new_bin;
+    };
+
+    const Hypergraph& graph;
+    AnnealingOptions options;
+    Placement& placement;
+    std::mt19937_64 rng;
+    std::vector<int> movable; // movable node ids
+    std::vector<int> node_row; // node id -> row of a movable node, -1 for the others
+    // pins of every node, grouped by net, and the position of every pin relative to the lower left corner of its node
+    std::vector<int> node_pin_offsets;
+    std::vector<int> node_pins;
+    std::vector<int> pin_net;
+    std::vector<double> pin_offset_x;
+    std::vector<double> pin_offset_y;
+    std::vector<NetBox> boxes; // net id -> cached bounding box, nets of less than 2 pins have none
+    double hpwl;
+    // boxes of the nets of the move under evaluation
+    std::vector<int> net_stage; // net id -> index in staged_nets, -1 if not staged
+    std::vector<int> staged_nets;
+    std::vector<NetBox> staged_boxes;
+    std::vector<char> staged_rescan;
+    MovedNode moved[2];
+    int num_moved;
+    // density bins, one row high and bin_width wide
+    double core_x_min;
+    double core_x_max;
+    double bin_width;
+    int bins_per_row;
+    std::vector<double> bin_area; // area of the movable nodes centered in the bin
+    std::vector<double> bin_capacity; // area of the free sites of the bin
+    std::vector<std::vector<int> > bin_nodes; // movable nodes centered in the bin
+    std::vector<int> node_bin; // node id -> bin of a movable node
+    std::vector<int> node_slot; // node id -> index in bin_nodes[node_bin]
+    double overflow; // sum of the area over the capacity of every bin
+    double density_weight; // absolute weight of the overflow area in the cost
+    double pending_hpwl; // deltas of the move under evaluation
+    double pending_overflow;
+    std::vector<int> touched_bins;
+    double mean_node_width;
+    // range limiter
+    double window_x;
+    double window_y;
+
+    double _uniform() { return static_cast<double>(rng() >> 11) * (1.0 / 9007199254740992.0); }
+    double _bin_overflow(int bin) const { return std::max(0.0, bin_area[bin] - bin_capacity[bin]); }
+    int _bin_of(int row, double x, double width) const;
+    // position of a node moved to x on row, snapped to the sites and clamped to the row
+    double _snap(int row, double x, double width) const;
+    void _rescan(int net, NetBox& box) const;
+    // stage the box of a net, return its index in the staged boxes
+    int _stage(int net);
+    void _stage_move(int node, double old_x, double old_y);
+    // ## evaluate the move of the moved nodes, positions already applied, return the cost delta
+    double _evaluate();
+    void _commit();
+    void _undo();
+    // ## propose a random move, apply it to the positions and return false if there is none
+    bool _propose();
+    void _legalize(AnnealingResult& result);
+public:
+    AnnealingPlacer(const Hypergraph& graph, Placement& placement, const AnnealingOptions& options);
+    AnnealingResult run();
+    int num_movable_nodes() const { return static_cast<int>(movable.size()); }
+};
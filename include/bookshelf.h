@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+
+#include "hypergraph.h"
+
+// ## files of a Bookshelf design, as listed in its .aux file
+// a file missing from the .aux line falls back to <aux basename>.<extension>
+struct BookshelfFiles {
+public:
+    std::string nodes;
+    std::string nets;
+    std::string wts;
+    std::string pl;
+    std::string scl;
+};
+
+// ## read the .aux file, e.g. "RowBasedPlacement : superblue1.nodes superblue1.nets superblue1.wts superblue1.pl superblue1.scl"
+BookshelfFiles read_bookshelf_aux(const std::string& aux_file_dir);
+
+// ## load a .nodes file into an empty hypergraph
+// the file is memory mapped and tokenized in place, node names go straight into graph.node_names
+// a node name defined twice is an error
+void load_bookshelf_nodes(const std::string& nodes_file_dir, Hypergraph& graph);
+
+// ## load a .nets file into a hypergraph that already holds the nodes, and finalize it
+// the file is split at "NetDegree" lines into one chunk per thread, the chunks are parsed in parallel
+// and then copied into the pin arrays at their prefix sum offsets
+// ### input:
+//      - num_threads: number of parser threads, 0 for one per hardware thread
+void load_bookshelf_nets(const std::string& nets_file_dir, Hypergraph& graph, int num_threads = 0);
+
+// ## write a hypergraph as a Bookshelf design: <base>.aux, <base>.nodes and <base>.nets, base is aux_file_dir without .aux
+// the .aux only lists the .nodes and .nets files, the pins are written as inputs
+// the nodes and the nets are formatted in parallel chunks, see write_parallel
+// ### input:
+//      - num_threads: number of formatting threads, 0 for one per hardware thread
+// ### output:
+//      - whether the files were written, error is set otherwise
+bool write_bookshelf(const std::string& aux_file_dir, const Hypergraph& graph, std::string& error, int num_threads = 0);
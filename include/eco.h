@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "fm.h"
+#include "hypergraph.h"
+#include "partition_io.h"
+
+// ## engineering change order: nodes and nets added to and removed from a netlist
+// removing a node also removes its pins, nets left without pins disappear
+// the pins of the added nets may refer to existing nodes and to added nodes
+struct ECOPin {
+public:
+    std::string node;
+    float delta_width;
+    float delta_height;
+};
+
+struct ECONet {
+public:
+    std::string name;
+    std::vector<ECOPin> pins;
+};
+
+struct ECONode {
+public:
+    std::string name;
+    double width;
+    double height;
+    NodeTypeEnum node_type;
+};
+
+struct NetlistECO {
+public:
+    std::vector<ECONode> added_nodes;
+    std::vector<std::string> removed_nodes;
+    std::vector<ECONet> added_nets;
+    std::vector<std::string> removed_nets;
+};
+
+// ## read an ECO file, Bookshelf like, one change per line:
+//      AddNode : <name> <width> <height> [terminal]
+//      RemoveNode : <name>
+//      AddNet : <degree> <name>, followed by <degree> pin lines "<node> I : <delta width> <delta height>" as in a .nets file
+//      RemoveNet : <name>
+// lines starting with # are comments
+// ### output:
+//      - whether the file was read, error is set otherwise
+bool read_eco(const std::string& eco_file_dir, NetlistECO& eco, std::string& error);
+
+// ## hypergraph after an ECO, and where the old ids went
+// the surviving nodes and nets keep their order, the added ones come after them
+struct ECOResult {
+public:
+    Hypergraph graph;
+    std::vector<int> old_to_new_node; // old node id -> new node id, -1 if removed
+    int num_added_nodes; // the added nodes are the last ids of graph
+    std::vector<int> touched_nodes; // new ids of the added nodes and of the nodes on the nets that changed, in increasing order
+};
+
+// ## apply an ECO to a hypergraph
+// the CSR arrays are rebuilt by one linear copy, with a flag per old node and net; the name lookups and the touched nodes are
+// proportional to the size of the change
+// the names stay unique: an added node or net may not take the name of a surviving one, or of another added one
+// ### output:
+//      - whether every name of the ECO was valid, error is set otherwise and result is left unspecified
+bool apply_eco(const Hypergraph& graph, const NetlistECO& eco, ECOResult& result, std::string& error);
+
+// ## options of the incremental repartitioning after an ECO
+struct ECOOptions {
+public:
+    FMOptions fm; // options of the bounded refinement
+    int radius; // the refined region holds the nodes within this many nets of a touched node
+    int max_region_nodes; // the region stops growing at this many nodes
+    ECOOptions();
+};
+
+// ## carry a partition over an ECO
+// the surviving nodes keep their part, an added node goes to the part holding most pins of its nets, or the lighter part on a tie
+std::vector<int> carry_partition(const ECOResult& result, const std::vector<int>& old_partition, int area_constraint);
+
+// ## region around the touched nodes, breadth first over the nets of at most fm.large_net_threshold nodes
+std::vector<int> eco_region(const Hypergraph& graph, const std::vector<int>& touched_nodes, const ECOOptions& options);
+
+// ## bounded FM refinement of a warm start partition: only the region moves, see FMBipartitioner::set_free_nodes
+// the gains and the moves scale with the region, but the setup does not: the FMBipartitioner sizes its arrays for the whole
+// graph and run() recounts the pins of every net, O(nodes + pins) once per ECO
+// ### output:
+//      - the cut size of the refined partition
+int incremental_refine(const Hypergraph& graph, std::vector<int>& partition, const std::vector<int>& region, const ECOOptions& options);
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "hypergraph.h"
+#include "metrics.h"
+#include "thread_pool.h"
+#include "utility.h"
+
+// ## how the gains treat nets with more than large_net_threshold nodes
+enum class LargeNetPolicy{
+    exact, // no special case, every net updates the gains of its nodes
+    exclude, // large nets never contribute to a gain
+    counter_only // large nets contribute to the gains computed at the start of a pass, moves only update their pin counters
+};
+
+// ## stops FM runs from any thread, e.g. a request handler or a signal handler
+class CancellationToken {
+private:
+    std::atomic<bool> cancelled;
+public:
+    CancellationToken() : cancelled(false) {}
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    void reset() { cancelled.store(false, std::memory_order_relaxed); }
+    bool is_cancelled() const { return cancelled.load(std::memory_order_relaxed); }
+};
+
+// ## progress of an FM run, given to the progress callback
+struct FMProgress {
+public:
+    int pass;
+    long long moves; // moves of the run so far, the moves undone by the rollbacks included
+    int cut; // cut after the last move
+    int best_cut; // best cut of the run so far, the one run() returns if it stops now
+    double elapsed_ms; // since the start of run()
+};
+
+// ## why an FM run stopped before it converged
+enum class FMStopReason {
+    none, // converged, or ran max_passes passes
+    deadline,
+    move_budget,
+    cancelled
+};
+
+// ## per-run scratch memory of FMBipartitioner, the buffers are resized by every run and keep their capacity
+struct FMScratch {
+public:
+    std::vector<double> node_weight; // node size or 1, depends on the area constraint
+    std::vector<int> partition; // node id -> partition 0 or 1
+    std::vector<int> num_of_nodes_in_partition; // net id -> pins in partition 0 and 1 at [2*net] and [2*net+1]
+    std::vector<char> node_locked;
+    std::vector<int> move_log; // nodes moved in the current pass, in order
+    std::vector<char> large_net; // net id -> whether the gains treat the net by the large net policy
+    std::vector<int> large_net_gain; // node id -> part of its bucket gain that comes from large nets
+    BucketArray buckets[2];
+    std::vector<int> initial_gain; // node id -> gain at the start of the pass, before it goes to the bucket
+    std::vector<int> free_nodes;
+    std::vector<char> node_fixed; // node id -> whether the node is fixed, empty without fixed nodes
+    std::vector<int> movable_nodes; // the nodes that are not fixed, in increasing order, empty without fixed nodes
+    std::vector<int> free_net_node_offsets; // net id -> free nodes of the net, CSR like Hypergraph::net_nodes, empty without fixed nodes
+    std::vector<int> free_net_nodes;
+
+    // visit(buffer) on every buffer, in a fixed order
+    template <typename Visitor>
+    void for_each_buffer(Visitor&& visit) {
+        visit(node_weight);
+        visit(partition);
+        visit(num_of_nodes_in_partition);
+        visit(node_locked);
+        visit(move_log);
+        visit(large_net);
+        visit(large_net_gain);
+        visit(buckets[0]);
+        visit(buckets[1]);
+        visit(initial_gain);
+        visit(free_nodes);
+        visit(node_fixed);
+        visit(movable_nodes);
+        visit(free_net_node_offsets);
+        visit(free_net_nodes);
+    }
+};
+
+// ## allocation counters of an FMWorkspace
+struct FMWorkspaceStats {
+public:
+    long long runs; // FMBipartitioner objects that used the workspace
+    long long allocations; // times a buffer had to grow, a run that fits in the memory of the earlier ones makes none
+    size_t scratch_bytes; // held by the buffers now
+    size_t peak_scratch_bytes;
+    FMWorkspaceStats() : runs(0), allocations(0), scratch_bytes(0), peak_scratch_bytes(0) {}
+};
+
+// ## scratch memory kept by a caller that partitions many hypergraphs, e.g. the blocks of a batch or the levels of a multilevel run
+// an FMBipartitioner built with the workspace takes its buffers for its lifetime and gives them back, grown, when it is destroyed,
+// so the runs after the largest one allocate nothing; one FMBipartitioner uses a workspace at a time, concurrent ones need one each
+class FMWorkspace {
+private:
+    friend class FMBipartitioner;
+    FMScratch scratch;
+    std::atomic<bool> in_use; // set by exchange, so that two FMBipartitioner objects cannot both take the buffers
+    std::vector<size_t> buffer_bytes; // capacity of every buffer at the last accounting
+    FMWorkspaceStats stats;
+
+    // count the buffers that grew since the last accounting
+    void _account(FMScratch& buffers);
+public:
+    FMWorkspace() : in_use(false) {}
+    FMWorkspace(const FMWorkspace&) = delete;
+    FMWorkspace& operator=(const FMWorkspace&) = delete;
+    const FMWorkspaceStats& statistics() const { return stats; }
+    // ## free the buffers, the counters stay
+    void release();
+};
+
+// ## options of the Fiduccia-Mattheyses bipartitioner
+struct FMOptions {
+public:
+    int area_constraint; // 0: balance the number of nodes, 1: balance the total area
+    int max_unbalanced_nodes; // each part may be this many max size nodes more/less than its target size
+    double max_imbalance; // if >= 0, the size each part may be more/less than its target size, overrides max_unbalanced_nodes
+    double target_fraction; // target size of partition 0 as a fraction of the total, partition 1 gets the rest
+    int max_passes; // stop after this many passes
+    double min_relative_improvement; // stop when a pass reduces the cut by less than this fraction of the cut before the pass
+    LargeNetPolicy large_net_policy;
+    int large_net_threshold; // nets with more nodes are large, unless the policy is exact
+    int dump_level; // 0 for brief dump, 1 for full dump, -1 for no dump
+    int progress_interval; // with dump level 1, print the progress every this many moves, and sample the cut into the metrics
+    Metrics* metrics; // phases, counters and histograms of the runs, nullptr to disable, not owned
+    int num_threads; // threads of the pin counter and gain initialization, 1 for serial, <= 0 for one per hardware thread
+    ThreadPool* pool; // if not nullptr, the initialization runs on this pool instead of its own num_threads, not owned
+    bool fix_terminals; // terminals never move, they keep the part of the initial partition unless fixed_part gives one
+    const std::vector<int>* fixed_part; // node id -> part the node is fixed in, -1 for a free node, nullptr for none, not owned
+    FMWorkspace* workspace; // if not nullptr, the scratch memory of the runs comes from this workspace instead of new buffers, not owned
+    // ## anytime controls: a run that stops rolls its pass back to the best prefix, so it returns the best partition it found
+    // the deadline, the cancellation and the progress callback are checked every control_interval moves, the budget at every move
+    std::chrono::high_resolution_clock::time_point deadline; // time_point::max() for none, absolute so that the runs of the levels of a multilevel partitioning share it
+    long long max_moves; // moves of one run(), over all its passes, 0 for no budget
+    const CancellationToken* cancellation; // nullptr for none, not owned
+    std::function<void(const FMProgress&)> progress_callback; // also called after every pass, only from the thread of run()
+    int control_interval;
+    FMOptions();
+};
+
+// ## statistics of one FM pass
+struct FMPassStats {
+public:
+    int pass;
+    int moves; // moves made in the pass
+    int best_prefix; // moves kept after the rollback
+    int cut_before; // the cut, or the connectivity (sum over the nets of their parts - 1) for KWayFMRefiner
+    int cut_after;
+    long long gain_update_visits; // pins visited to update gains
+    long long skipped_visits; // pins the exact policy would have visited on large nets
+    double gain_init_ms; // part of time_ms spent to compute the gains and fill the buckets
+    double time_ms;
+};
+
+// ## multi-pass Fiduccia-Mattheyses bipartitioner on a hypergraph
+// every pass moves each free node at most once, appending the moves to a move log, then rolls back
+// to the prefix of the log with the minimum cut; pin counters and partition sizes are kept across passes
+// with a large net policy, the moves update the cut of the large nets from their pin counters, so the cut stays exact
+// while the gains, which decide the moves, ignore the large nets or see them as they were at the start of the pass
+// the pin counters and the cut are computed in parallel over the nets, the gains in parallel over the nodes, and the buckets
+// are then filled in node order, so the result does not depend on the number of threads
+// fixed nodes count in the pin counters, the cut and the part sizes, but the gains only see the free nodes of every net:
+// a fixed node is never in a bucket, never locked or unlocked, and never visited by the gain updates
+class FMBipartitioner : private FMScratch {
+private:
+    const Hypergraph& graph;
+    FMOptions options;
+    long long gain_update_visits;
+    long long skipped_visits;
+    double partition_size[2];
+    double target_size[2];
+    double max_imbalance;
+    int cut_size;
+    std::vector<FMPassStats> stats;
+    std::function<bool(const FMPassStats&)> pass_callback;
+    std::chrono::high_resolution_clock::time_point run_start;
+    long long run_moves; // moves of the passes before the current one
+    FMStopReason stopped;
+    MetricsBlock metrics_block; // counters and histograms of the current pass, merged into options.metrics after the pass
+    std::unique_ptr<ThreadPool> own_pool;
+    ThreadPool* pool; // options.pool, own_pool, or nullptr for a serial initialization
+    std::unique_ptr<FMWorkspace> own_workspace;
+    FMWorkspace* workspace; // options.workspace or own_workspace, its buffers are the FMScratch of this object until it is destroyed
+    bool restricted; // whether only free_nodes may move
+
+    // the nodes of a net the gain updates visit
+    IdRange _free_nodes_of(int net) const {
+        if (free_net_node_offsets.empty()) {
+            return graph.nodes_of(net);
+        }
+        return {free_net_nodes.data() + free_net_node_offsets[net], free_net_nodes.data() + free_net_node_offsets[net + 1]};
+    }
+
+    // run body(chunk_begin, chunk_end) on chunks of [0, end), on the pool if there is one
+    void _parallel_for(int end, const std::function<void(int, int)>& body);
+
+    void _initialize_counters();
+    // gain of moving a node, the part that comes from large nets is also kept in large_net_gain
+    int _compute_gain(int node);
+    void _initialize_gains();
+    // move a node and update the pin counters, and the gains of its free neighbors if update_gains
+    // the passes and moves are compiled with and without the metrics, so that a run without them does not pay for them
+    template <bool with_metrics>
+    void _move(int node, bool update_gains);
+    template <bool with_metrics>
+    FMPassStats _pass(int pass);
+    // whether the deadline passed, the run was cancelled, or moves reached the budget, safe to call from any thread
+    FMStopReason _check_stop(long long moves) const;
+    // check the controls in the middle of a pass, with the cut after the last move and the best cut of the pass
+    bool _should_stop(int pass, long long moves, int cut, int best_cut);
+public:
+    FMBipartitioner(const Hypergraph& graph, FMOptions options);
+    // gives the buffers back to the workspace
+    ~FMBipartitioner();
+    FMBipartitioner(const FMBipartitioner&) = delete;
+    FMBipartitioner& operator=(const FMBipartitioner&) = delete;
+    // ## run passes until convergence, the deadline, the move budget or the cancellation
+    // ### input:
+    //      - partition: initial node id -> partition 0 or 1, overwritten with the best partition found
+    // ### output:
+    //      - the cut size of the returned partition
+    int run(std::vector<int>& partition);
+    // ## bounded refinement: only these nodes move, and only their gains are computed by the passes
+    // the other nodes stay where the initial partition puts them, but still count in the pin counters and the cut, which run()
+    // still initializes over all the nets; fixed nodes in the list stay fixed
+    void set_free_nodes(std::vector<int> nodes);
+    int num_fixed_nodes() const { return node_fixed.empty() ? 0 : graph.num_nodes() - static_cast<int>(movable_nodes.size()); }
+    // ## called after every pass, returning false stops the run with the partition of that pass
+    void set_pass_callback(std::function<bool(const FMPassStats&)> callback) { pass_callback = std::move(callback); }
+    double part_size(int part) const { return partition_size[part]; }
+    double max_allowed_imbalance() const { return max_imbalance; }
+    const std::vector<FMPassStats>& pass_stats() const { return stats; }
+    // ## why the last run stopped, FMStopReason::none if it converged
+    FMStopReason stop_reason() const { return stopped; }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+
+#include "hypergraph.h"
+
+// ## options of the synthetic netlist generator
+struct GeneratorOptions {
+public:
+    int num_nodes;
+    int num_nets;
+    long long num_pins; // exact number of pins, 0 for the mean of the degree distribution
+    double degree_exponent; // net degrees d >= 2 follow P(d) ~ d^-degree_exponent, adjusted to reach num_pins
+    int max_net_degree;
+    double terminal_fraction; // the last nodes are terminals
+    double macro_fraction; // probability of a movable node to be a macro
+    double macro_scale; // mean area of a macro in mean standard cell areas
+    double row_height; // height of the standard cells and of the placement rows
+    double locality; // probability of a pin to be near the center of its net in node id order, otherwise anywhere
+    int locality_window; // a near pin is at most max(locality_window, degree) ids from the center
+    double utilization; // movable area / core area of the .scl rows
+    unsigned seed; // the design only depends on the options
+    GeneratorOptions();
+};
+
+// ## what the generator produced
+struct GeneratorStats {
+public:
+    int num_nodes;
+    int num_terminals;
+    int num_macros;
+    int num_nets;
+    long long num_pins;
+    int max_net_degree;
+};
+
+// ## generate a netlist in memory
+Hypergraph generate_hypergraph(const GeneratorOptions& options, GeneratorStats* stats = nullptr);
+
+// ## write a Bookshelf design: <base>.aux, .nodes, .nets, .wts, .pl and .scl, where <base> is aux_file_dir without .aux
+// the nodes and nets are streamed to the files, the same options give the same netlist as generate_hypergraph
+// the .pl file spreads the movable nodes at random over the rows of the .scl file and fixes the terminals on the core boundary
+// ### output:
+//      - whether all the files were written, an error is printed otherwise
+bool generate_bookshelf(const std::string& aux_file_dir, const GeneratorOptions& options, GeneratorStats* stats = nullptr);
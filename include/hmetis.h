@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "hypergraph.h"
+
+// ## hMETIS hypergraph files (.hgr)
+// first line "<num nets> <num vertices> [fmt]", fmt 1 for net weights, 10 for vertex weights, 11 for both
+// then one line per net with its 1-based vertices, preceded by the net weight if fmt has net weights,
+// then one line per vertex with its weight if fmt has vertex weights; lines starting with % are comments
+// a vertex of weight w becomes a node of width w and height 1, so its size is w, a vertex without weight has size 1
+// node i is named after its 1-based hMETIS id i + 1, net i after i + 1 as well
+
+// ## whether a design file is an hMETIS file, by its .hgr extension
+bool is_hmetis_file(const std::string& file_dir);
+
+// ## load an .hgr file into an empty hypergraph, and finalize it
+// the body is split at line starts into one chunk per thread, the chunks are parsed in parallel
+// ### input:
+//      - num_threads: number of parser threads, 0 for one per hardware thread
+// ### output:
+//      - whether the file was loaded, error is set otherwise
+//      - net_weights: if not nullptr, the weight of every net, 1 when the file has none
+bool load_hmetis(const std::string& hgr_file_dir, Hypergraph& graph, std::string& error, std::vector<int>* net_weights = nullptr, int num_threads = 0);
+
+// ## write a hypergraph as an .hgr file, the nets list their distinct nodes
+// vertex weights are written when a node size is not 1, rounded to the nearest integer of at least 1
+// net weights are written when net_weights is not nullptr
+// the nets are formatted in parallel chunks, see write_parallel
+bool write_hmetis(const std::string& hgr_file_dir, const Hypergraph& graph, std::string& error, const std::vector<int>* net_weights = nullptr, int num_threads = 0);
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class NodeTypeEnum{
+    node,
+    terminal,
+    terminal_nl
+};
+
+// ## contiguous range of ids inside a CSR array, usable in range-for
+struct IdRange {
+public:
+    const int* first;
+    const int* last;
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    int size() const { return static_cast<int>(last - first); }
+};
+
+// ## interned names: dense id <-> name, only used at I/O time
+// names are stored back to back in one character pool, the lookup index is an
+// open addressing table of ids, so it never points into the (growing) pool
+class NameTable {
+private:
+    std::vector<char> pool; // all names, back to back
+    std::vector<int64_t> offsets; // name i is pool[offsets[i], offsets[i+1])
+    std::vector<uint64_t> slots; // open addressing index: (upper hash bits << 32) | (id + 1), 0 for empty slot
+    bool indexed; // whether slots reflect every name in the pool
+
+    static uint64_t _hash(std::string_view name);
+    void _rehash(size_t num_slots);
+    void _index(int id);
+public:
+    NameTable();
+    // append a name and return its id, does not check for duplicates
+    int add(std::string_view name);
+    // return the id of name, append it first if it is not there yet
+    int intern(std::string_view name);
+    // return the id of name, or -1 if it does not exist
+    // building the index is not thread safe, call build_index() before sharing the table between threads
+    int find(std::string_view name) const;
+    void build_index();
+    // stop maintaining the index while bulk loading, the next find() or build_index() rebuilds it
+    void drop_index();
+    void reserve(size_t num_names, size_t num_chars);
+    void clear();
+    int size() const { return static_cast<int>(offsets.size()) - 1; }
+    std::string_view operator[](int id) const {
+        return std::string_view(pool.data() + offsets[id], static_cast<size_t>(offsets[id + 1] - offsets[id]));
+    }
+    size_t memory_bytes() const;
+    // raw storage, for serialization
+    const std::vector<char>& characters() const { return pool; }
+    const std::vector<int64_t>& name_offsets() const { return offsets; }
+    // replace the content with num_names names stored back to back, name i is characters[name_offsets[i], name_offsets[i+1])
+    void assign(const char* characters, const int64_t* name_offsets, int num_names);
+};
+
+// ## hypergraph with dense integer node and net ids
+// - pins: every pin of the netlist in file order, grouped by net (net -> pins CSR)
+// - net_nodes: the distinct nodes of each net (net -> nodes CSR)
+// - node_nets: the distinct nets of each node (node -> nets CSR)
+// nodes are added first, then nets pin by pin, finalize() builds the two incidence arrays
+struct Hypergraph {
+public:
+    // node table, indexed by node id
+    std::vector<double> node_width;
+    std::vector<double> node_height;
+    std::vector<double> node_size;
+    std::vector<NodeTypeEnum> node_type;
+    NameTable node_names;
+
+    // pins, indexed by pin id, pins of net i are [net_pin_offsets[i], net_pin_offsets[i+1])
+    std::vector<int> net_pin_offsets;
+    std::vector<int> pin_node;
+    std::vector<float> pin_delta_width;
+    std::vector<float> pin_delta_height;
+    NameTable net_names;
+
+    // distinct nodes of each net, and distinct nets of each node
+    std::vector<int> net_node_offsets;
+    std::vector<int> net_nodes;
+    std::vector<int> node_net_offsets;
+    std::vector<int> node_nets;
+
+    Hypergraph();
+    int num_nodes() const { return static_cast<int>(node_size.size()); }
+    int num_nets() const { return static_cast<int>(net_pin_offsets.size()) - 1; }
+    int num_pins() const { return static_cast<int>(pin_node.size()); }
+    IdRange pins_of(int net) const { return {pin_node.data() + net_pin_offsets[net], pin_node.data() + net_pin_offsets[net + 1]}; }
+    IdRange nodes_of(int net) const { return {net_nodes.data() + net_node_offsets[net], net_nodes.data() + net_node_offsets[net + 1]}; }
+    IdRange nets_of(int node) const { return {node_nets.data() + node_net_offsets[node], node_nets.data() + node_net_offsets[node + 1]}; }
+
+    // ## builder interface
+    int add_node(std::string_view name, double width, double height, NodeTypeEnum node_type = NodeTypeEnum::node);
+    int add_net(std::string_view name);
+    // append a pin to the last added net
+    void add_pin(int node, float delta_width, float delta_height);
+    // build net_nodes and node_nets from the pins
+    void finalize();
+    void clear();
+
+    // ## sub-hypergraph of the nodes with part_of[node] == part
+    // every net keeps the pins that fall into this part, nets left with less than min_net_nodes nodes are dropped
+    Hypergraph extract(const std::vector<int>& part_of, int part, int min_net_nodes = 1) const;
+
+    size_t memory_bytes() const;
+};
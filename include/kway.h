@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "hypergraph.h"
+#include "multilevel.h"
+
+// ## options of the k-way partitioner
+struct KWayOptions {
+public:
+    int num_parts; // k
+    double imbalance; // every part may weigh up to (1 + imbalance) times total / k
+    bool multilevel; // bisect with the multilevel bipartitioner, otherwise with FM from a random balanced start
+    MultilevelOptions bisection; // options of every bisection, balance, target and seed are set per bisection; fm.area_constraint and fm.dump_level apply to the k-way partition; fm.fixed_part is not supported, the subproblems renumber the nodes
+    bool refine; // improve the connectivity of the bisection result with direct k-way FM, see include/kway_fm.h
+    int num_threads; // <= 0 for one thread per hardware thread
+    unsigned seed; // the result only depends on the seed, never on the number of threads
+    KWayOptions();
+};
+
+// ## k-way partition and its quality
+struct KWayResult {
+public:
+    int num_parts;
+    std::vector<int> part; // node id -> part 0 .. num_parts - 1
+    std::vector<double> part_weight; // size or number of nodes of each part, depends on the area constraint
+    int cut; // nets with nodes in more than one part
+    long long connectivity; // sum over all nets of (number of parts of the net - 1)
+    double imbalance; // heaviest part / (total / num_parts) - 1
+};
+
+// ## fill part_weight, cut, connectivity and imbalance of result from result.part
+void evaluate_kway(const Hypergraph& graph, int area_constraint, KWayResult& result);
+
+// ## k-way partition by recursive bisection
+// a subproblem of k' parts is bisected into ceil(k'/2) and floor(k'/2) parts with a target weight fraction to match,
+// the two halves are then bisected as independent tasks of a work stealing thread pool
+// the tolerance of every bisection is (1 + imbalance') with imbalance' = ((1 + imbalance) * k' * total / (k * subproblem total))^(1 / ceil(log2 k')) - 1,
+// so the parts meet the final balance after ceil(log2 k') levels, it is never less than the heaviest node of the subproblem
+// if options.refine, direct k-way FM then repairs the decisions of the upper levels, its passes and stop rule are those of bisection.fm;
+// with bisection.fm.fix_terminals it keeps every terminal in the part the bisections gave it
+// ### input:
+//      - graph: the hypergraph to partition
+//      - options: number of parts, balance, bisection options, threads and seed
+// ### output:
+//      - the partition, with its cut and connectivity
+KWayResult recursive_bisection(const Hypergraph& graph, const KWayOptions& options);
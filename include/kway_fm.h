@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include "fm.h"
+#include "hypergraph.h"
+#include "utility.h"
+
+// ## direct k-way FM refinement of the connectivity objective, sum over all nets of (number of parts of the net - 1)
+// generalizes FMBipartitioner to k parts:
+//      - pin counts of every net in every part in one flat array, [net * k + part]
+//      - a gain cache per node: benefit, the nets on which the node is the only pin of its part, and connection[node * k + part],
+//        the nets of the node with pins in part; the gain of moving node to part is benefit + connection - degree
+//      - the cache of a node is computed the first time the node is touched, then kept exact by delta updates on every move
+//      - one bucket holds every free boundary node with the gain of its best move; the target is checked again against the
+//        part weights when the node is popped, and the node goes back with its current gain if it changed
+// a move is allowed while the target part stays within max_part_weight, the weights are node sizes or 1 as in FMBipartitioner
+// with options.fix_terminals, the terminals never enter the bucket and keep the part of the initial partition
+// every pass moves each free node at most once, then rolls back to the prefix of the move log with the minimum connectivity
+// the cache takes num_nodes * num_parts ints
+class KWayFMRefiner {
+private:
+    const Hypergraph& graph;
+    FMOptions options;
+    int num_parts;
+    double max_part_weight;
+    std::vector<double> node_weight; // node size or 1, depends on the area constraint
+    std::vector<int> part; // node id -> part
+    std::vector<double> part_weight;
+    std::vector<int> pin_count; // net id -> pins in each part at [net * num_parts + part]
+    std::vector<int> net_parts; // net id -> number of parts with pins of the net
+    std::vector<char> cache_valid;
+    std::vector<int> benefit;
+    std::vector<int> connection; // node id -> nets with pins in each part at [node * num_parts + part]
+    std::vector<int> target; // node id -> target part of the node in the bucket
+    std::vector<char> node_fixed; // node id -> terminal kept in its part by options.fix_terminals
+    std::vector<char> node_locked;
+    std::vector<int> touched; // free nodes whose gain may have changed by the last move
+    std::vector<char> is_touched;
+    std::vector<int> move_log; // nodes moved in the current pass, in order
+    std::vector<int> move_from; // part of each logged node before its move
+    BucketArray bucket;
+    long long connectivity;
+    std::vector<FMPassStats> stats;
+
+    void _initialize_counters();
+    void _compute_cache(int node);
+    // best allowed target part of a node and its gain, -1 if no connected part can take the node
+    int _best_target(int node, int& gain) const;
+    // put a node in the bucket with its best move, or take it out
+    void _refresh(int node);
+    // move a node and update the pin counters and the valid caches, and the bucket if update_gains
+    void _move(int node, int to_part, bool update_gains);
+    FMPassStats _pass(int pass);
+public:
+    KWayFMRefiner(const Hypergraph& graph, int num_parts, double max_part_weight, FMOptions options);
+    // ## run passes until convergence
+    // ### input:
+    //      - partition: initial node id -> part, overwritten with the best partition found
+    // ### output:
+    //      - the connectivity of the returned partition
+    long long run(std::vector<int>& partition);
+    double weight_of_part(int p) const { return part_weight[p]; }
+    // cut_before and cut_after of the pass statistics hold the connectivity, gain_update_visits and skipped_visits are 0
+    const std::vector<FMPassStats>& pass_stats() const { return stats; }
+};
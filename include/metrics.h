@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// ## counters of the partitioning engines
+enum class MetricCounter {
+    moves, // moves of the passes, the moves undone by the rollback to the best prefix included
+    gain_updates, // pins visited to update gains
+    bucket_reinserts, // gain changes, each one relinks a node in its bucket
+    max_gain_rescans, // empty gain lists stepped over to find the max gain node
+    nets_touched, // nets walked by the gain updates of the moves
+    num_counters
+};
+
+// ## histograms of the partitioning engines
+enum class MetricHistogram {
+    move_gain, // gain of every move
+    net_degree_touched, // degree of every net walked by the gain updates
+    num_histograms
+};
+
+const char* metric_name(MetricCounter counter);
+const char* metric_name(MetricHistogram histogram);
+
+// ## histogram of integers in power of two bins: ..., [-3, -2], -1, 0, 1, [2, 3], [4, 7], ...
+class Log2Histogram {
+public:
+    static const int num_bins = 129;
+    std::array<long long, num_bins> bins;
+    long long count;
+    long long sum;
+    long long min;
+    long long max;
+    Log2Histogram();
+    void add(long long value) {
+        bins[bin_of(value)]++;
+        count++;
+        sum += value;
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+    }
+    void merge(const Log2Histogram& other);
+    static int bin_of(long long value) {
+        if (value == 0) {
+            return num_bins / 2;
+        }
+        unsigned long long magnitude = value > 0 ? static_cast<unsigned long long>(value) : 0ull - static_cast<unsigned long long>(value);
+        int log2 = 63 - __builtin_clzll(magnitude);
+        return value > 0 ? num_bins / 2 + 1 + log2 : num_bins / 2 - 1 - log2;
+    }
+    // smallest and largest value of a bin
+    static long long bin_low(int bin);
+    static long long bin_high(int bin);
+};
+
+// ## counters and histograms of one engine, updated without synchronization and merged into Metrics once in a while
+struct MetricsBlock {
+public:
+    std::array<long long, static_cast<int>(MetricCounter::num_counters)> counters;
+    std::array<Log2Histogram, static_cast<int>(MetricHistogram::num_histograms)> histograms;
+    MetricsBlock();
+    void clear();
+    void count(MetricCounter counter, long long n = 1) { counters[static_cast<int>(counter)] += n; }
+    void observe(MetricHistogram histogram, long long value) { histograms[static_cast<int>(histogram)].add(value); }
+};
+
+// ## one event of the trace, a phase with a duration or a sample of a value
+struct TraceEvent {
+public:
+    std::string name;
+    long long start_us; // since the creation of the Metrics
+    long long duration_us; // -1 for a sample
+    double value; // value of a sample
+    int thread; // small id of the thread, in order of first event
+};
+
+// ## metrics of a run: phases, counters, histograms and samples, shared by all the threads of the run
+// the engines take a Metrics* in their options, nullptr disables the metrics and their hot loops are compiled without them
+class Metrics {
+private:
+    mutable std::mutex mutex;
+    std::chrono::high_resolution_clock::time_point origin;
+    MetricsBlock totals;
+    std::vector<TraceEvent> events;
+    std::unordered_map<std::thread::id, int> thread_ids;
+
+    long long _us_since_origin(std::chrono::high_resolution_clock::time_point time) const;
+    int _thread_id();
+public:
+    Metrics();
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    void merge(const MetricsBlock& block);
+    void record_phase(const std::string& name, std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end);
+    void sample(const std::string& name, double value);
+    long long counter(MetricCounter counter) const;
+    Log2Histogram histogram(MetricHistogram histogram) const;
+    std::vector<TraceEvent> trace() const;
+    // ## {"phases": {name: {count, total_ms, max_ms}}, "counters": {...}, "histograms": {name: {count, sum, min, max, bins: [{low, high, count}]}}}
+    std::string to_json() const;
+    // ## Chrome trace event format, for chrome://tracing or Perfetto: phases are complete events, samples are counter events
+    std::string to_chrome_trace() const;
+    // print an error and return false if the file cannot be written
+    bool write_json(const std::string& file_dir) const;
+    bool write_chrome_trace(const std::string& file_dir) const;
+};
+
+// ## records the time from its construction to its destruction as a phase, does nothing without metrics
+class ScopedPhase {
+private:
+    Metrics* metrics;
+    const char* name;
+    std::chrono::high_resolution_clock::time_point start;
+public:
+    ScopedPhase(Metrics* metrics, const char* name) : metrics(metrics), name(name) {
+        if (metrics != nullptr) {
+            start = std::chrono::high_resolution_clock::now();
+        }
+    }
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+    ~ScopedPhase() {
+        if (metrics != nullptr) {
+            metrics->record_phase(name, start, std::chrono::high_resolution_clock::now());
+        }
+    }
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+#include "fm.h"
+#include "hypergraph.h"
+
+enum class CoarseningScheme{
+    heavy_edge, // match pairs of unmatched nodes
+    first_choice // a node may also join the cluster of an already clustered neighbor
+};
+
+// ## options of the multilevel bipartitioner
+struct MultilevelOptions {
+public:
+    FMOptions fm; // balance and passes of the initial partition and of every refinement, its dump level applies to the multilevel summary
+    CoarseningScheme coarsening;
+    int coarsest_nodes; // stop coarsening once a level has at most this many nodes
+    int max_levels;
+    double min_reduction; // stop coarsening when a level removes less than this fraction of the nodes
+    int max_rated_net_size; // nets with more nodes are ignored when rating neighbors
+    int initial_tries; // random starts refined with FM on the coarsest level, the best one is kept
+    unsigned seed;
+    MultilevelOptions();
+};
+
+// ## one level of the coarsening hierarchy
+struct CoarseLevel {
+public:
+    Hypergraph graph; // node_size holds the summed weights of the clustered nodes
+    std::vector<int> fine_to_coarse; // node of the finer level -> node of this level
+    std::vector<int> fixed_part; // node -> part it is fixed in, -1 for a free node, empty without fixed nodes
+};
+
+// ## cluster nodes by heavy edge rating, a net of n nodes adds 1/(n-1) to the rating of every pair of its nodes
+// the weight of a cluster never exceeds max_cluster_weight, the nodes fixed by fixed_part stay alone in their cluster
+// ### output:
+//      - node id -> cluster id, cluster ids are dense and numbered in order of their first node
+//      - num_clusters: number of clusters
+std::vector<int> cluster_nodes(const Hypergraph& graph, const std::vector<double>& node_weight, double max_cluster_weight, const MultilevelOptions& options, unsigned seed, int& num_clusters, const std::vector<int>* fixed_part = nullptr);
+
+// ## contract the clusters into nodes, a net keeps one pin per cluster, nets left with a single cluster are dropped
+// names are not kept, the size of a cluster is the sum of the node_weight of its nodes
+Hypergraph contract_hypergraph(const Hypergraph& graph, const std::vector<double>& node_weight, const std::vector<int>& cluster, int num_clusters);
+
+// ## multilevel bipartition: coarsen, partition the coarsest level, then project back level by level with FM refinement
+// ### input:
+//      - graph: the hypergraph to partition
+//      - options: coarsening and FM options, the balance is computed on graph and kept on every level
+//        the nodes of fm.fixed_part are fixed on every level, the terminals of fm.fix_terminals only on the finest one
+// ### output:
+//      - partition: node id -> partition 0 or 1
+//      - the cut size
+int multilevel_bipartition(const Hypergraph& graph, const MultilevelOptions& options, std::vector<int>& partition);
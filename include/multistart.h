@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "fm.h"
+#include "hypergraph.h"
+
+// ## options of the multi-start bipartitioner
+struct MultiStartOptions {
+public:
+    FMOptions fm; // options of every start, its dump level applies to the multi-start summary
+    int num_starts;
+    int num_threads; // <= 0 for one thread per hardware thread
+    unsigned seed; // start i uses the seed + i, the best start does not depend on the number of threads
+    double cancel_margin; // if >= 0, stop a start from its second pass on when its cut is above (1 + cancel_margin) times the best cut any start had after the same pass
+    MultiStartOptions();
+};
+
+// ## result of every start and the best partition
+struct MultiStartResult {
+public:
+    std::vector<int> partition; // node id -> partition 0 or 1, of the best start
+    int cut;
+    int best_start;
+    std::vector<int> start_cut; // cut of every start, when it finished or was cancelled
+    std::vector<int> start_passes;
+    std::vector<char> start_cancelled;
+    std::vector<double> start_time_ms;
+};
+
+// ## run independent FM starts in parallel and keep the best one
+// every start has its own random number generator and its own FMBipartitioner, the hypergraph is shared read only
+// the initial partition of a start puts the nodes, in random order, on the part that is lighter so far
+// ties between starts go to the lowest start index, so without cancellation the result only depends on the seed;
+// the cancellation compares starts that run at the same time, it depends on their timing
+MultiStartResult multi_start_bipartition(const Hypergraph& graph, const MultiStartOptions& options);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "hypergraph.h"
+
+// ## partition files: one "<node name> <part>" line per node
+// if every_node is false, the file may list only some of the nodes, e.g. the fixed ones, and the others get part -1
+// if num_parts > 0, the parts must be in [0, num_parts)
+// ### output:
+//      - whether every node of the graph got a part in range, or every_node is false, error is set otherwise
+bool read_partition_file(const std::string& file_dir, const Hypergraph& graph, std::vector<int>& partition, std::string& error, bool every_node = true, int num_parts = 0);
+
+// ## the writers below format their lines in parallel chunks and write them in order with large writes, see write_parallel
+// num_threads is the number of formatting threads, 0 for one per hardware thread
+// they return whether the file was written, error is set otherwise
+bool write_partition_file(const std::string& file_dir, const Hypergraph& graph, const std::vector<int>& partition, std::string& error, int num_threads = 0);
+
+// ## hMETIS partition file: line i holds the part of node i, as written by hmetis in <graph>.part.<k>
+bool write_hmetis_partition_file(const std::string& file_dir, const std::vector<int>& partition, std::string& error, int num_threads = 0);
+
+// ## cut nets: one "<net name> <degree> <part> <part> ..." line per net with nodes in more than one part, with its parts in increasing order
+bool write_cut_nets_file(const std::string& file_dir, const Hypergraph& graph, const std::vector<int>& partition, std::string& error, int num_threads = 0);
+
+// ## one Bookshelf design per part: <base>_<part>.aux, .nodes and .nets, see write_bookshelf
+// the design of a part is Hypergraph::extract of the part, its nets keep the pins that fall into the part
+bool write_part_designs(const std::string& base, const Hypergraph& graph, const std::vector<int>& partition, int num_parts, std::string& error, int num_threads = 0);
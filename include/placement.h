@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "hypergraph.h"
+
+// ## one placement row of the .scl file, the sites of the row are [x_min, x_max)
+struct PlacementRow {
+public:
+    double y; // Coordinate, bottom of the row
+    double height;
+    double site_width;
+    double site_spacing;
+    double x_min; // SubrowOrigin
+    double x_max; // SubrowOrigin + NumSites * Sitespacing
+};
+
+// ## positions of the nodes and the rows they are placed on
+// x and y are the lower left corners as in the .pl file, a pin sits at the center of its node plus its pin offset
+struct Placement {
+public:
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<char> fixed; // node id -> whether the node never moves: a terminal, or /FIXED in the .pl file
+    std::vector<PlacementRow> rows; // in increasing order of y
+};
+
+// ## read the rows of a .scl file
+// ### output:
+//      - whether the file was read, error is set otherwise
+bool read_bookshelf_scl(const std::string& scl_file_dir, std::vector<PlacementRow>& rows, std::string& error);
+
+// ## read the positions of a .pl file, one "<name> <x> <y> : <orientation> [/FIXED | /FIXED_NI]" line per node
+// the nodes missing from the file are at (0, 0), the terminals of the graph and the /FIXED nodes are fixed
+bool read_bookshelf_pl(const std::string& pl_file_dir, const Hypergraph& graph, Placement& placement, std::string& error);
+
+// ## write the positions as a .pl file, the fixed nodes are marked /FIXED
+bool write_bookshelf_pl(const std::string& pl_file_dir, const Hypergraph& graph, const Placement& placement, std::string& error, int num_threads = 0);
+
+// ## read the .scl and .pl files listed in a Bookshelf .aux file
+bool load_bookshelf_placement(const std::string& aux_file_dir, const Hypergraph& graph, Placement& placement, std::string& error);
+
+// ## half perimeter wirelength of one net, and of the whole design
+double net_hpwl(const Hypergraph& graph, const Placement& placement, int net);
+double total_hpwl(const Hypergraph& graph, const Placement& placement);
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "hypergraph.h"
+#include "metrics.h"
+#include "placement.h"
+#include "sparse.h"
+
+// ## options of the quadratic placer
+struct QuadraticOptions {
+public:
+    int clique_max_degree; // nets with up to this many pins use the clique model, larger nets the star model
+    double center_weight; // weight of the pull of every movable node to the center of the core, keeps the systems regular
+    ConjugateGradientOptions solver;
+    int spreading_levels; // levels of min-cut bisection of the core that spread the nodes, 0 for no spreading
+    double spreading_imbalance; // area the halves of a bisection may be more/less than their capacity, as a fraction of the region area
+    double anchor_weight; // after spreading, weight of the pull of every node to its spread position, relative to the weight of its nets, 0 to keep the spread positions
+    int num_threads; // 1 for serial, <= 0 for one thread per hardware thread
+    int dump_level; // 0 for one line per step, -1 for no dump
+    Metrics* metrics; // phases of the run, nullptr to disable, not owned
+    QuadraticOptions();
+};
+
+// ## result of a quadratic placement
+struct QuadraticResult {
+public:
+    int num_variables; // movable nodes and star nodes
+    int num_entries; // of the matrix
+    int iterations_x; // of the last solve
+    int iterations_y;
+    double initial_hpwl;
+    double solved_hpwl; // after the first solve
+    double spread_hpwl; // after spreading
+    double hpwl; // final
+    double solved_overflow; // area over the capacity of the density bins, as a fraction of the movable area
+    double overflow;
+    double assemble_ms;
+    double solve_ms;
+    double spread_ms;
+};
+
+// ## analytical quadratic placement: minimize the sum over the connections of weight * squared distance, in x and in y
+// a net of p pins is a clique of connections of weight 1 / (p - 1), or a star of connections of weight p / (p - 1) to an extra
+// star node, the two give the same forces; connections join pins, so the pin offsets move to the right hand side
+// the movable nodes are the nodes that are not fixed and fit in a row, as for AnnealingPlacer; the others are anchors
+// the x and y systems share one matrix, solved by the Jacobi preconditioned conjugate gradient on the pool
+// spreading bisects the core recursively: the nodes of a region are split at the capacity weighted median of their
+// coordinate across the cut line, the split is refined by FMBipartitioner on the subgraph of the region, and every leaf region
+// spreads its nodes over its area keeping their relative positions; a last solve then pulls the nodes to their spread positions
+class QuadraticPlacer {
+private:
+    // a region of the spreading bisection
+    struct Region {
+    public:
+        double x_min;
+        double x_max;
+        double y_min;
+        double y_max;
+        std::vector<int> nodes; // node ids, in increasing order
+        Hypergraph graph; // the nodes and the nets between them, node i of graph is nodes[i]
+    };
+
+    const Hypergraph& graph;
+    QuadraticOptions options;
+    Placement& placement;
+    std::unique_ptr<ThreadPool> pool; // nullptr with one thread
+    std::vector<int> movable; // movable node ids
+    std::vector<int> node_variable; // node id -> variable of a movable node, -1 for the others
+    std::vector<int> star_net; // star variable - movable.size() -> its net
+    SparseMatrix matrix;
+    std::vector<double> rhs_x;
+    std::vector<double> rhs_y;
+    double core_x_min;
+    double core_x_max;
+    double core_y_min;
+    double core_y_max;
+    double row_height; // of the tallest row
+    std::vector<int> blockages; // nodes that do not move and overlap the core
+    // square density bins a few rows high, to measure the overlap
+    double bin_size;
+    int bins_x;
+    int bins_y;
+    std::vector<double> bin_capacity; // area of the free sites of the bin
+
+    void _assemble();
+    // solve the systems from the current positions, with a pull of anchor_weight[node] to (anchor_x[node], anchor_y[node]) on every
+    // movable node, all empty for none, and move the nodes to the solution
+    void _solve(const std::vector<double>& anchor_weight, const std::vector<double>& anchor_x, const std::vector<double>& anchor_y, QuadraticResult& result);
+    // area of the free sites in a rectangle
+    double _capacity(double x_min, double x_max, double y_min, double y_max) const;
+    // bin overflow of the movable nodes centered in the bins, as a fraction of their area
+    double _overflow() const;
+    void _bisect(Region& region, int level, std::vector<double>& target_x, std::vector<double>& target_y) const;
+    void _spread(std::vector<double>& target_x, std::vector<double>& target_y) const;
+public:
+    QuadraticPlacer(const Hypergraph& graph, Placement& placement, const QuadraticOptions& options);
+    QuadraticResult run();
+    int num_movable_nodes() const { return static_cast<int>(movable.size()); }
+};
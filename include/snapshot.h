@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hypergraph.h"
+
+// ## binary hypergraph snapshot
+// layout: SnapshotHeader, then the payload sections in the order below, each padded to 8 bytes
+//      - node_width, node_height (double), node_type (uint8)
+//      - node name offsets (int64), node name characters
+//      - net_pin_offsets, pin_node (int32), pin_delta_width, pin_delta_height (float)
+//      - net name offsets (int64), net name characters
+//      - net_node_offsets, net_nodes, node_net_offsets, node_nets (int32)
+// the checksum covers the whole payload, the file is only valid on a machine with the same byte order
+struct SnapshotHeader {
+public:
+    char magic[8]; // "VLSIHGS\0"
+    uint32_t version;
+    uint32_t byte_order; // 0x01020304 as written by the producing machine
+    uint64_t num_nodes;
+    uint64_t num_nets;
+    uint64_t num_pins;
+    uint64_t num_incidences; // size of net_nodes and of node_nets
+    uint64_t node_name_chars;
+    uint64_t net_name_chars;
+    uint64_t payload_bytes;
+    uint64_t checksum;
+};
+
+const uint32_t snapshot_version = 1;
+
+// ## default snapshot file of a design: <aux basename>.hgsnap
+std::string default_snapshot_file(const std::string& aux_file_dir);
+
+// ## whether snapshot_file_dir exists and was modified after every file in source_file_dirs, false if a source file is missing
+bool snapshot_is_fresh(const std::string& snapshot_file_dir, const std::vector<std::string>& source_file_dirs);
+
+// ## write a finalized hypergraph to a snapshot, through a temporary file renamed into place
+// return false and set error if the file cannot be written
+bool write_hypergraph_snapshot(const Hypergraph& graph, const std::string& snapshot_file_dir, std::string& error);
+
+// ## map a snapshot, validate it and fill graph from it
+// return false and set error if the file is missing, truncated, of another version or corrupted, graph is then left empty
+bool load_hypergraph_snapshot(const std::string& snapshot_file_dir, Hypergraph& graph, std::string& error);
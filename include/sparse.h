@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include "thread_pool.h"
+
+// ## symmetric sparse matrix: the diagonal apart, and the off-diagonal entries of every row in CSR form
+// both (i, j) and (j, i) are stored, the columns of a row are in increasing order
+struct SparseMatrix {
+public:
+    int num_rows;
+    std::vector<double> diagonal;
+    std::vector<int> row_offsets; // row -> its entries at [row_offsets[row], row_offsets[row + 1])
+    std::vector<int> columns;
+    std::vector<double> values;
+    SparseMatrix() : num_rows(0) {}
+    int num_entries() const { return num_rows + static_cast<int>(columns.size()); }
+};
+
+// ## builds a SparseMatrix from unordered (row, column, value) entries, duplicate entries are summed
+class SparseMatrixBuilder {
+private:
+    int num_rows;
+    std::vector<double> diagonal;
+    std::vector<int> entry_rows;
+    std::vector<int> entry_columns;
+    std::vector<double> entry_values;
+public:
+    explicit SparseMatrixBuilder(int num_rows);
+    void add_diagonal(int row, double value) { diagonal[row] += value; }
+    // ## add value at (row, column) and (column, row), row != column
+    void add_symmetric(int row, int column, double value);
+    // ## counting sort of the entries by row, then sort and merge the columns of every row, rows in parallel on the pool if not nullptr
+    SparseMatrix build(ThreadPool* pool = nullptr);
+};
+
+// ## options of the conjugate gradient solver
+struct ConjugateGradientOptions {
+public:
+    double tolerance; // stop once the residual norm is below tolerance times the norm of the right hand side
+    int max_iterations;
+    ConjugateGradientOptions();
+};
+
+// ## result of a conjugate gradient solve
+struct ConjugateGradientResult {
+public:
+    int iterations;
+    double relative_residual;
+    bool converged;
+};
+
+// ## Jacobi preconditioned conjugate gradient for A x = b, x holds the initial guess and is overwritten with the solution
+// the matrix product and the vector updates run on chunks of rows of the pool, if not nullptr; the streaming loops over the
+// vectors are plain loops the compiler vectorizes, and the dot products are added over the chunks in order, so the iterates
+// do not depend on the number of threads
+ConjugateGradientResult conjugate_gradient(const SparseMatrix& a, const std::vector<double>& b, std::vector<double>& x, const ConjugateGradientOptions& options, ThreadPool* pool = nullptr);
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <charconv>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// ## read only memory mapping of a whole file
+class MappedFile {
+private:
+    const char* mapped_data;
+    size_t mapped_size;
+public:
+    MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+    // map the file, return false if it cannot be opened or mapped
+    bool open(const std::string& file_dir);
+    void close();
+    const char* data() const { return mapped_data; }
+    size_t size() const { return mapped_size; }
+    const char* begin() const { return mapped_data; }
+    const char* end() const { return mapped_data + mapped_size; }
+};
+
+// ## hand written whitespace tokenizer over a character range
+// tokens are string_views into the range, numbers are parsed with std::from_chars
+struct TextScanner {
+public:
+    const char* cur;
+    const char* end;
+
+    TextScanner(const char* begin, const char* end) : cur(begin), end(end) {}
+    static bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+    static bool is_space(char c) { return is_blank(c) || c == '\n'; }
+    // skip spaces and tabs, but not newlines
+    void skip_blanks() {
+        while (cur < end && is_blank(*cur)) {
+            cur++;
+        }
+    }
+    // skip all whitespace including newlines
+    void skip_space() {
+        while (cur < end && is_space(*cur)) {
+            cur++;
+        }
+    }
+    void skip_line() {
+        while (cur < end && *cur != '\n') {
+            cur++;
+        }
+        if (cur < end) {
+            cur++;
+        }
+    }
+    bool at_end() {
+        skip_space();
+        return cur >= end;
+    }
+    // whether only blanks are left on the current line
+    bool at_line_end() {
+        skip_blanks();
+        return cur >= end || *cur == '\n';
+    }
+    // next token, possibly on a later line, empty at the end of the range
+    std::string_view token() {
+        skip_space();
+        const char* first = cur;
+        while (cur < end && !is_space(*cur)) {
+            cur++;
+        }
+        return std::string_view(first, static_cast<size_t>(cur - first));
+    }
+    // next token on the current line, empty if the line has no more tokens
+    std::string_view token_in_line() {
+        if (at_line_end()) {
+            return std::string_view();
+        }
+        return token();
+    }
+    bool parse_int(int& value) {
+        std::string_view t = token();
+        return std::from_chars(t.data(), t.data() + t.size(), value).ec == std::errc() && !t.empty();
+    }
+    bool parse_double(double& value) {
+        std::string_view t = token();
+        return std::from_chars(t.data(), t.data() + t.size(), value).ec == std::errc() && !t.empty();
+    }
+    bool parse_float(float& value) {
+        std::string_view t = token();
+        return std::from_chars(t.data(), t.data() + t.size(), value).ec == std::errc() && !t.empty();
+    }
+};
+
+// ## number and text formatting of TextBuffer and TextWriter, Derived provides append(const char* data, size_t size)
+// numbers are formatted with std::to_chars, integers exactly, doubles and floats in their shortest round trip form for their type
+template <typename Derived>
+class TextFormatter {
+private:
+    Derived& _self() { return static_cast<Derived&>(*this); }
+public:
+    Derived& operator<<(std::string_view text) {
+        _self().append(text.data(), text.size());
+        return _self();
+    }
+    Derived& operator<<(const char* text) { return *this << std::string_view(text); }
+    Derived& operator<<(char c) { return *this << std::string_view(&c, 1); }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    Derived& operator<<(T value) {
+        char digits[24];
+        char* last = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        return *this << std::string_view(digits, static_cast<size_t>(last - digits));
+    }
+    Derived& operator<<(double value) {
+        char digits[32];
+        char* last = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        return *this << std::string_view(digits, static_cast<size_t>(last - digits));
+    }
+    // a float widened to double would print the digits of its binary value, e.g. 0.30000001192092896 for 0.3f
+    Derived& operator<<(float value) {
+        char digits[32];
+        char* last = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        return *this << std::string_view(digits, static_cast<size_t>(last - digits));
+    }
+};
+
+// ## text formatted in memory, e.g. one chunk of a file formatted by one thread
+class TextBuffer : public TextFormatter<TextBuffer> {
+public:
+    std::string text;
+    void append(const char* data, size_t size) { text.append(data, size); }
+    void clear() { text.clear(); }
+};
+
+// ## buffered text output to a file
+// the buffer goes to the file whenever it holds more than buffer_bytes
+class TextWriter : public TextFormatter<TextWriter> {
+private:
+    FILE* file;
+    std::string buffer;
+    size_t buffer_bytes;
+    bool failed;
+public:
+    TextWriter();
+    TextWriter(const TextWriter&) = delete;
+    TextWriter& operator=(const TextWriter&) = delete;
+    ~TextWriter();
+    // create or truncate the file, return false if it cannot be opened
+    bool open(const std::string& file_dir, size_t buffer_bytes = 1 << 22);
+    void flush();
+    // flush and close the file, return false if any write failed
+    bool close();
+    void append(const char* data, size_t size) {
+        buffer.append(data, size);
+        if (buffer.size() >= buffer_bytes) {
+            flush();
+        }
+    }
+    // write a large block as is, after the buffered text
+    void write(std::string_view text);
+};
+
+class ThreadPool;
+
+// ## format the items [0, count) in parallel and write them in order
+// the items are split into chunks of grain items and format(buffer, chunk_begin, chunk_end) formats one chunk into its own buffer,
+// the pool formats a batch of chunks at a time, then the batch goes to the file in chunk order with one large write per chunk
+// the output never depends on the pool, without a pool the chunks are formatted by the calling thread
+void write_parallel(TextWriter& writer, int count, int grain, ThreadPool* pool, const std::function<void(TextBuffer&, int, int)>& format);
+
+// ## 1-based line number of position in text, for error messages
+int line_number_of(const char* text_begin, const char* position);
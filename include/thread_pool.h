@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ## tasks submitted together, wait() returns once all of them, and the tasks they submitted, finished
+struct TaskGroup {
+public:
+    std::atomic<int> pending;
+    TaskGroup() : pending(0) {}
+};
+
+// ## work stealing thread pool
+// every worker owns a deque: it pushes and pops its own tasks at the back, and steals from the front of the
+// other deques when its own is empty; tasks submitted by other threads go to an extra shared deque
+// a thread waiting for a group runs tasks meanwhile, so tasks may submit and wait for subtasks
+class ThreadPool {
+private:
+    struct Task {
+    public:
+        std::function<void()> run;
+        TaskGroup* group;
+    };
+    struct TaskQueue {
+    public:
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    std::vector<std::unique_ptr<TaskQueue> > queues; // one per worker, the last one for threads outside the pool
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping;
+    std::atomic<int> queued; // tasks in all the queues
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_condition;
+
+    int _self() const;
+    bool _pop(int queue, Task& task, bool from_back);
+    bool _try_run_one(int self);
+    void _worker(int self);
+public:
+    // num_threads <= 0 for one worker per hardware thread
+    explicit ThreadPool(int num_threads = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+    int num_threads() const { return static_cast<int>(workers.size()); }
+    void submit(TaskGroup& group, std::function<void()> task);
+    // run tasks until every task of the group finished
+    void wait(TaskGroup& group);
+    // ## split [begin, end) into chunks of grain items and run body(chunk_begin, chunk_end) on each of them
+    // the chunks only depend on the range and the grain, never on the number of threads
+    void parallel_for(int begin, int end, int grain, const std::function<void(int, int)>& body);
+};
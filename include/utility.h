@@ -8,11 +8,11 @@
 
 struct BucketNode {
 public:
-    std::string name;
+    int id;
     int gain;
     double size;
     BucketNode();
-    BucketNode(std::string name, int gain, double size);
+    BucketNode(int id, int gain, double size);
 };
 
 class Bucket {
@@ -21,7 +21,7 @@ private:
     std::unordered_map<int, std::list<BucketNode> > gain_buckets;
 
     // cell_map: id -> iterator of Node in gain_buckets
-    std::unordered_map<std::string, std::list<BucketNode>::iterator> cell_map;
+    std::unordered_map<int, std::list<BucketNode>::iterator> cell_map;
 
     // max_gain: maximum gain in current bucket
     int max_gain;
@@ -35,17 +35,103 @@ private:
 public:
     Bucket(int maximum_possible_gain);
     void insert(BucketNode node);
-    void insert(std::string name, int gain, double size);
-    void erase(std::string name);
-    void update_gain(std::string name, int new_gain);
-    void increase_gain(std::string name);
-    void decrease_gain(std::string name);
+    void insert(int id, int gain, double size);
+    void erase(int id);
+    void update_gain(int id, int new_gain);
+    void increase_gain(int id);
+    void decrease_gain(int id);
     bool is_empty() const;
     // ## get a copy of max gain node object
     // ### output: BucketNode struct:
-    // - std::string name;
+    // - int id;
     // - int gain;
     // - double size;
     BucketNode get_max_gain_node();
     void dump() const;
+};
+
+// ## classic FM bucket array over integer ids
+// gain + pmax -> intrusive doubly linked list of ids, every operation is O(1) and allocation free
+// the max gain pointer only moves up on insert/increase, and moves down lazily when the max gain node is requested
+// same tie breaking as Bucket: among the nodes of max gain, the one inserted or updated last is returned
+class BucketArray {
+private:
+    std::vector<int> heads; // gain + pmax -> first id in the list, -1 if empty
+    std::vector<int> next; // id -> next id in the same list, -1 for the tail
+    std::vector<int> prev; // id -> previous id in the same list, -1 for the head
+    std::vector<int> gains; // id -> current gain
+    std::vector<char> in_bucket; // id -> whether the id is in the bucket
+    int max_index; // upper bound of the index of the highest non empty list
+    int num_entries;
+    int max_possible_gain;
+
+    void _link(int id, int index) {
+        next[id] = heads[index];
+        prev[id] = -1;
+        if (heads[index] >= 0) {
+            prev[heads[index]] = id;
+        }
+        heads[index] = id;
+        if (index > max_index) {
+            max_index = index;
+        }
+    }
+    void _unlink(int id, int index) {
+        if (prev[id] >= 0) {
+            next[prev[id]] = next[id];
+        }
+        else {
+            heads[index] = next[id];
+        }
+        if (next[id] >= 0) {
+            prev[next[id]] = prev[id];
+        }
+    }
+public:
+    BucketArray();
+    BucketArray(int maximum_possible_gain, int num_ids);
+    // clear the bucket and resize it, keeps the allocated memory when possible
+    void reset(int maximum_possible_gain, int num_ids);
+    void insert(int id, int gain) {
+        gains[id] = gain;
+        in_bucket[id] = true;
+        num_entries++;
+        _link(id, gain + max_possible_gain);
+    }
+    void erase(int id) {
+        _unlink(id, gains[id] + max_possible_gain);
+        in_bucket[id] = false;
+        num_entries--;
+    }
+    void update_gain(int id, int new_gain) {
+        _unlink(id, gains[id] + max_possible_gain);
+        gains[id] = new_gain;
+        _link(id, new_gain + max_possible_gain);
+    }
+    void increase_gain(int id) { update_gain(id, gains[id] + 1); }
+    void decrease_gain(int id) { update_gain(id, gains[id] - 1); }
+    bool contains(int id) const { return in_bucket[id]; }
+    int gain(int id) const { return gains[id]; }
+    bool is_empty() const { return num_entries == 0; }
+    int size() const { return num_entries; }
+    int max_gain_bound() const { return max_possible_gain; }
+    // upper bound of gain + pmax of the max gain node, lowered by the max gain lookups
+    int max_gain_index() const { return max_index; }
+    // memory held by the lists
+    size_t capacity_bytes() const { return (heads.capacity() + next.capacity() + prev.capacity() + gains.capacity()) * sizeof(int) + in_bucket.capacity(); }
+    // id of a max gain node, -1 if the bucket is empty
+    int get_max_gain_node() {
+        if (num_entries == 0) {
+            return -1;
+        }
+        while (heads[max_index] < 0) {
+            max_index--;
+        }
+        return heads[max_index];
+    }
+    int get_max_gain() {
+        int id = get_max_gain_node();
+        return id < 0 ? -max_possible_gain : gains[id];
+    }
+    void dump() const;
 };
\ No newline at end of file
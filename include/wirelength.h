@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "hypergraph.h"
+#include "placement.h"
+#include "thread_pool.h"
+
+// ## half perimeter wirelength of a placement, and its split over the parts of a partition
+struct WirelengthReport {
+public:
+    double total;
+    double cut; // nets with nodes in more than one part
+    int num_cut_nets;
+    std::vector<double> parts; // part -> nets with all their nodes in the part
+    double evaluate_ms; // gathering the pin coordinates excluded
+};
+
+// ## half perimeter wirelength evaluator over a structure of arrays of pin coordinates
+// the coordinates of pin i of the graph are pin_x[i] and pin_y[i], so the pins of a net are contiguous and the bounding box
+// of a net is a min/max reduction over SIMD lanes; the nets are split into chunks of a fixed size evaluated in parallel,
+// and the chunk sums are added in order, so the result does not depend on the number of threads
+class HpwlEvaluator {
+private:
+    const Hypergraph& graph;
+    std::unique_ptr<ThreadPool> pool; // nullptr with one thread
+    // offset of every pin from the lower left corner of its node: half the node plus the pin delta
+    std::vector<double> pin_offset_x;
+    std::vector<double> pin_offset_y;
+    std::vector<double> pin_x;
+    std::vector<double> pin_y;
+
+    void _parallel_for(int begin, int end, int grain, const std::function<void(int, int)>& body) const;
+public:
+    // num_threads <= 0 for one thread per hardware thread
+    explicit HpwlEvaluator(const Hypergraph& graph, int num_threads = 0);
+    // ## gather the pin coordinates of a placement, call it again after the nodes moved
+    void set_placement(const Placement& placement);
+    double net_hpwl(int net) const;
+    double total() const;
+    // ## total wirelength, and with partition (node id -> part in [0, num_parts)) the wirelength inside every part and on the cut
+    WirelengthReport report(const std::vector<int>* partition = nullptr, int num_parts = 0) const;
+};
@@ -1,13 +1,54 @@
 #include <iostream>
+#include <csignal>
 #include <cstdlib>
 
 #include "include/VLSI.h"
+#include "include/bookshelf.h"
+#include "include/snapshot.h"
+#include "include/wirelength.h"
+
+// cancels the FM runs on Ctrl-C, they then return the best partition found so far
+CancellationToken interrupt_token;
+
+void interrupt(int) {
+    interrupt_token.cancel();
+}
 
 // accept command line arguments
 int main(int argc, char* argv[]) {
     Circuit circuit;
     int dump_level = 0;
     std::string aux_file_dir = "datasets/superblue1/superblue1.aux";
+    std::string snapshot_file_dir = "";
+    bool use_snapshot = true;
+    bool save_snapshot = false;
+    FMOptions fm_options;
+    fm_options.num_threads = 0;
+    long long time_limit_ms = 0;
+    bool multilevel = false;
+    KWayOptions kway_options;
+    kway_options.num_parts = 0;
+    MultiStartOptions multi_start_options;
+    multi_start_options.num_starts = 0;
+    std::string metrics_file_dir = "";
+    std::string trace_file_dir = "";
+    std::string partition_file_dir = "";
+    std::string save_partition_file_dir = "";
+    std::string hmetis_partition_file_dir = "";
+    std::string cut_file_dir = "";
+    std::string parts_base = "";
+    std::string hgr_file_dir = "";
+    std::string bookshelf_file_dir = "";
+    bool place = false;
+    bool quadratic = false;
+    QuadraticOptions quadratic_options;
+    AnnealingOptions annealing_options;
+    std::string pl_file_dir = "";
+    bool hpwl = false;
+    std::string eco_file_dir = "";
+    ECOOptions eco_options;
+    std::string fixed_file_dir = "";
+    std::vector<int> fixed_part;
     // check if there is an argument like "--dump 1 --dir datasets/superblue1/superblue1.aux"
     for (int i = 1; i < argc; i++) {
         if (std::string(argv[i]) == "--dump") {
@@ -18,27 +59,395 @@ int main(int argc, char* argv[]) {
             aux_file_dir = argv[i + 1];
             i++;
         }
+        else if (std::string(argv[i]) == "--snapshot") {
+            snapshot_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--save-snapshot") {
+            save_snapshot = true;
+        }
+        else if (std::string(argv[i]) == "--no-snapshot") {
+            use_snapshot = false;
+        }
+        else if (std::string(argv[i]) == "--passes") {
+            fm_options.max_passes = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--min-improvement") {
+            fm_options.min_relative_improvement = std::stod(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--large-net-threshold") {
+            fm_options.large_net_threshold = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--large-net-policy") {
+            std::string policy = argv[i + 1];
+            if (policy == "exact") {
+                fm_options.large_net_policy = LargeNetPolicy::exact;
+            }
+            else if (policy == "exclude") {
+                fm_options.large_net_policy = LargeNetPolicy::exclude;
+            }
+            else if (policy == "counter") {
+                fm_options.large_net_policy = LargeNetPolicy::counter_only;
+            }
+            else {
+                std::cerr << "Error: unknown large net policy " << policy << ", expected exact, exclude or counter" << std::endl;
+                return 1;
+            }
+            i++;
+        }
+        else if (std::string(argv[i]) == "--multilevel") {
+            multilevel = true;
+        }
+        else if (std::string(argv[i]) == "--parts" || std::string(argv[i]) == "-k") {
+            kway_options.num_parts = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--imbalance") {
+            kway_options.imbalance = std::stod(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--no-refine") {
+            kway_options.refine = false;
+        }
+        else if (std::string(argv[i]) == "--starts") {
+            multi_start_options.num_starts = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--cancel-margin") {
+            multi_start_options.cancel_margin = std::stod(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--seed") {
+            kway_options.seed = multi_start_options.seed = annealing_options.seed = std::stoul(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--threads") {
+            kway_options.num_threads = multi_start_options.num_threads = fm_options.num_threads = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--time-limit") {
+            time_limit_ms = std::stoll(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--max-moves") {
+            fm_options.max_moves = std::stoll(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--progress") {
+            fm_options.progress_interval = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--metrics") {
+            metrics_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--trace") {
+            trace_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--partition") {
+            partition_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--save-partition") {
+            save_partition_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--save-hmetis") {
+            hmetis_partition_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--save-cut") {
+            cut_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--save-parts") {
+            parts_base = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--save-hgr") {
+            hgr_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--save-bookshelf") {
+            bookshelf_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--place") {
+            place = true;
+        }
+        else if (std::string(argv[i]) == "--quadratic") {
+            quadratic = true;
+        }
+        else if (std::string(argv[i]) == "--spread-levels") {
+            quadratic_options.spreading_levels = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--anneal-moves") {
+            annealing_options.moves_per_node = std::stod(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--save-pl") {
+            pl_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--hpwl") {
+            hpwl = true;
+        }
+        else if (std::string(argv[i]) == "--eco") {
+            eco_file_dir = argv[i + 1];
+            i++;
+        }
+        else if (std::string(argv[i]) == "--eco-radius") {
+            eco_options.radius = std::stoi(argv[i + 1]);
+            i++;
+        }
+        else if (std::string(argv[i]) == "--fix-terminals") {
+            fm_options.fix_terminals = true;
+        }
+        else if (std::string(argv[i]) == "--fixed") {
+            fixed_file_dir = argv[i + 1];
+            i++;
+        }
         else if (std::string(argv[i]) == "--help" || std::string(argv[i]) == "-h") {
-            std::cout << "Usage: " << argv[0] << " [--dump <level>] [--dir <aux_file_dir>]" << std::endl;
-            std::cout << "  --dump <level> : dump level (0, 1)" << std::endl;
-            std::cout << "  --dir <aux_file_dir> : directory of the .aux file" << std::endl;
+            std::cout << "Usage: " << argv[0] << " [--dump <level>] [--dir <aux_file_dir>] [--snapshot <file>] [--save-snapshot] [--no-snapshot] [--passes <n>] [--min-improvement <fraction>] [--large-net-threshold <n>] [--large-net-policy <policy>] [--multilevel] [--parts <k>] [--imbalance <fraction>] [--no-refine] [--starts <n>] [--cancel-margin <fraction>] [--seed <n>] [--threads <n>] [--time-limit <ms>] [--max-moves <n>] [--progress <n>] [--metrics <file>] [--trace <file>] [--partition <file>] [--save-partition <file>] [--save-hmetis <file>] [--save-cut <file>] [--save-parts <base>] [--save-hgr <file>] [--save-bookshelf <aux_file_dir>] [--place] [--quadratic] [--spread-levels <n>] [--anneal-moves <n>] [--save-pl <file>] [--hpwl] [--eco <file>] [--eco-radius <n>] [--fix-terminals] [--fixed <file>]" << std::endl;
+            std::cout << "  --dump <level> : dump level (0, 1), level 1 prints the FM progress every --progress moves" << std::endl;
+            std::cout << "  --dir <aux_file_dir> : directory of the .aux file, or of an hMETIS .hgr file, ./generate writes synthetic designs" << std::endl;
+            std::cout << "  --snapshot <file> : load the circuit from this binary snapshot instead of the .aux file" << std::endl;
+            std::cout << "  --save-snapshot : after loading, save a snapshot to <aux basename>.hgsnap, later runs load it automatically while it is newer than the .aux, .nodes and .nets files" << std::endl;
+            std::cout << "  --no-snapshot : ignore <aux basename>.hgsnap and parse the text files" << std::endl;
+            std::cout << "  --passes <n> : maximum number of FM passes (100)" << std::endl;
+            std::cout << "  --min-improvement <fraction> : stop when a pass reduces the cut by less than this fraction (0)" << std::endl;
+            std::cout << "  --large-net-threshold <n> : nets with more than n nodes are large (1000)" << std::endl;
+            std::cout << "  --large-net-policy <policy> : exact, gains follow every net; exclude, large nets never change a gain; counter, large nets only count in the gains at the start of a pass (exact)" << std::endl;
+            std::cout << "  --multilevel : coarsen the circuit, partition the coarsest level and refine every level with FM" << std::endl;
+            std::cout << "  --parts, -k <k> : partition into k parts by recursive multilevel bisection instead of bipartitioning" << std::endl;
+            std::cout << "  --imbalance <fraction> : with --parts, every part may weigh up to (1 + fraction) times total / k (0.05)" << std::endl;
+            std::cout << "  --no-refine : with --parts, skip the direct k-way FM refinement of the recursive bisection result" << std::endl;
+            std::cout << "  --starts <n> : run n FM starts from different seeds in parallel and keep the best one" << std::endl;
+            std::cout << "  --cancel-margin <fraction> : with --starts, stop a start from its second pass on when its cut is this fraction above the best cut of any start after the same pass" << std::endl;
+            std::cout << "  --seed <n> : seed of --parts, --starts and --place (13)" << std::endl;
+            std::cout << "  --threads <n> : number of threads of the loading, --parts, --starts, the FM initialization, --quadratic, --hpwl and the result files, 0 for one per hardware thread (0)" << std::endl;
+            std::cout << "  --time-limit <ms> : stop the FM passes this long after the partitioning starts and keep the best partition found, 0 for no limit (0); Ctrl-C stops them the same way" << std::endl;
+            std::cout << "  --max-moves <n> : stop an FM run after n moves and keep the best partition found, 0 for no limit (0)" << std::endl;
+            std::cout << "  --progress <n> : FM progress interval in moves, for --dump 1 and the cut samples of --trace (100000)" << std::endl;
+            std::cout << "  --metrics <file> : write the phase times, counters and histograms of the run as JSON" << std::endl;
+            std::cout << "  --trace <file> : write the phases and cut samples of the run in the Chrome trace event format" << std::endl;
+            std::cout << "  --partition <file> : start FM from this partition, one \"<node name> <part>\" line per node, instead of a random one" << std::endl;
+            std::cout << "  --save-partition <file> : write the resulting partition in the --partition format" << std::endl;
+            std::cout << "  --save-hmetis <file> : write the resulting partition in the hMETIS format, the part of node i on line i" << std::endl;
+            std::cout << "  --save-cut <file> : write the cut nets, one \"<net name> <degree> <parts>\" line per net" << std::endl;
+            std::cout << "  --save-parts <base> : write every part as a Bookshelf design <base>_<part>.aux, .nodes and .nets" << std::endl;
+            std::cout << "  --save-hgr <file> : after loading, write the circuit as an hMETIS .hgr file, node sizes as vertex weights" << std::endl;
+            std::cout << "  --save-bookshelf <aux_file_dir> : after loading, write the circuit as a Bookshelf .aux, .nodes and .nets design" << std::endl;
+            std::cout << "  --place : place the circuit on the rows of its .scl file by simulated annealing from its .pl file, instead of partitioning it" << std::endl;
+            std::cout << "  --quadratic : place the circuit by quadratic wirelength minimization, with the fixed nodes of its .pl file as anchors, instead of partitioning it; with --place the annealing starts from the result" << std::endl;
+            std::cout << "  --spread-levels <n> : with --quadratic, levels of min-cut bisection that spread the nodes over the core, 0 for no spreading (10)" << std::endl;
+            std::cout << "  --anneal-moves <n> : with --place, moves per movable node at every temperature (10)" << std::endl;
+            std::cout << "  --save-pl <file> : with --place or --quadratic, write the resulting placement as a .pl file" << std::endl;
+            std::cout << "  --hpwl : report the half perimeter wirelength of the .pl placement, or of the --place or --quadratic result, and its split over the parts and the cut nets of the partition" << std::endl;
+            std::cout << "  --eco <file> : apply this ECO to the circuit after partitioning it, or to the --partition one, then refine only the region around the change" << std::endl;
+            std::cout << "  --eco-radius <n> : with --eco, the refined region holds the nodes within n nets of the change (2)" << std::endl;
+            std::cout << "  --fix-terminals : terminals never move in the FM bipartitions and the k-way refinement, they keep their initial part" << std::endl;
+            std::cout << "  --fixed <file> : fix the nodes listed in this file, one \"<node name> <part>\" line per node, to their part 0 or 1, not with --parts" << std::endl;
             return 0;
         }
     }
-    circuit.load(aux_file_dir, dump_level);
+    // metrics are only collected when they are written somewhere
+    Metrics metrics;
+    Metrics* run_metrics = metrics_file_dir.empty() && trace_file_dir.empty() ? nullptr : &metrics;
+    auto write_metrics = [&]() {
+        bool written = true;
+        if (!metrics_file_dir.empty()) {
+            written = metrics.write_json(metrics_file_dir) && written;
+        }
+        if (!trace_file_dir.empty()) {
+            written = metrics.write_chrome_trace(trace_file_dir) && written;
+        }
+        return written;
+    };
+    // the result files of a partition, formatted by --threads threads
+    auto write_results = [&](const std::vector<int>& partition, int num_parts) {
+        std::string error;
+        bool written = (save_partition_file_dir.empty() || write_partition_file(save_partition_file_dir, circuit.hypergraph(), partition, error, fm_options.num_threads))
+            && (hmetis_partition_file_dir.empty() || write_hmetis_partition_file(hmetis_partition_file_dir, partition, error, fm_options.num_threads))
+            && (cut_file_dir.empty() || write_cut_nets_file(cut_file_dir, circuit.hypergraph(), partition, error, fm_options.num_threads))
+            && (parts_base.empty() || write_part_designs(parts_base, circuit.hypergraph(), partition, num_parts, error, fm_options.num_threads));
+        if (!written) {
+            std::cerr << "Error: " << error << std::endl;
+        }
+        return written;
+    };
+    auto report_wirelength = [&](const Placement& placement, const std::vector<int>* partition, int num_parts) {
+        HpwlEvaluator evaluator(circuit.hypergraph(), fm_options.num_threads);
+        evaluator.set_placement(placement);
+        WirelengthReport report;
+        {
+            ScopedPhase phase(run_metrics, "hpwl");
+            report = evaluator.report(partition, num_parts);
+        }
+        for (int part = 0; part < num_parts; part++) {
+            std::cout << "Part " << part << " hpwl: " << static_cast<long long>(report.parts[part]) << std::endl;
+        }
+        if (partition != nullptr) {
+            std::cout << "Cut nets hpwl: " << static_cast<long long>(report.cut) << ", " << report.num_cut_nets << " nets" << std::endl;
+        }
+        std::cout << "Total hpwl: " << static_cast<long long>(report.total) << std::endl;
+        if (dump_level == 0) {
+            std::cout << "Time to evaluate hpwl: " << report.evaluate_ms << " ms" << std::endl;
+        }
+    };
+    if (!snapshot_file_dir.empty()) {
+        if (!circuit.load_snapshot(snapshot_file_dir, dump_level, run_metrics)) {
+            return 1;
+        }
+    }
+    else {
+        circuit.load(aux_file_dir, dump_level, use_snapshot, run_metrics, fm_options.num_threads);
+        if (save_snapshot && !circuit.save_snapshot(default_snapshot_file(aux_file_dir))) {
+            return 1;
+        }
+    }
     // circuit.dump(dump_level);
+    if (!hgr_file_dir.empty() || !bookshelf_file_dir.empty()) {
+        std::string error;
+        if ((!hgr_file_dir.empty() && !write_hmetis(hgr_file_dir, circuit.hypergraph(), error, nullptr, fm_options.num_threads))
+            || (!bookshelf_file_dir.empty() && !write_bookshelf(bookshelf_file_dir, circuit.hypergraph(), error, fm_options.num_threads))) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+    }
+
+    if (place || quadratic) {
+        Placement placement;
+        std::string error;
+        if (is_hmetis_file(aux_file_dir) || !load_bookshelf_placement(aux_file_dir, circuit.hypergraph(), placement, error)) {
+            std::cerr << "Error: " << (error.empty() ? "--place and --quadratic need a Bookshelf design with .scl and .pl files" : error) << std::endl;
+            return 1;
+        }
+        if (quadratic) {
+            quadratic_options.num_threads = fm_options.num_threads;
+            quadratic_options.dump_level = dump_level == 0 ? 0 : -1;
+            quadratic_options.metrics = run_metrics;
+            QuadraticResult result = circuit.quadratic_placement(placement, quadratic_options);
+            std::cout << "Total hpwl: " << static_cast<long long>(result.hpwl) << ", overflow: " << result.overflow << std::endl;
+        }
+        if (place) {
+            annealing_options.dump_level = dump_level == 0 ? 0 : -1;
+            annealing_options.metrics = run_metrics;
+            AnnealingResult result = circuit.Timber_Wolf_placement(placement, annealing_options);
+            std::cout << "Total hpwl: " << static_cast<long long>(result.hpwl) << ", " << static_cast<long long>(result.moves_per_second) << " moves/s" << std::endl;
+        }
+        if (!pl_file_dir.empty() && !write_bookshelf_pl(pl_file_dir, circuit.hypergraph(), placement, error, fm_options.num_threads)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+        if (hpwl) {
+            report_wirelength(placement, nullptr, 0);
+        }
+        return write_metrics() ? 0 : 1;
+    }
+    Placement hpwl_placement;
+    if (hpwl) {
+        std::string error;
+        if (is_hmetis_file(aux_file_dir) || !read_bookshelf_pl(read_bookshelf_aux(aux_file_dir).pl, circuit.hypergraph(), hpwl_placement, error)) {
+            std::cerr << "Error: " << (error.empty() ? "--hpwl needs a Bookshelf design with a .pl file" : error) << std::endl;
+            return 1;
+        }
+    }
 
     // run Fiduccia-Mattheyses bipartition
-    int area_constraint = 1;
-    int max_unbalanced_nodes = 500;
-    Circuit partition1, partition2;
-    std::vector<CircuitNet> cut;
-    std::tie(partition1, partition2, cut) = circuit.Fiduccia_Mattheyses_bipartition(area_constraint, max_unbalanced_nodes, dump_level);
+    fm_options.area_constraint = 1;
+    fm_options.max_unbalanced_nodes = 500;
+    fm_options.dump_level = dump_level;
+    fm_options.metrics = run_metrics;
+    fm_options.cancellation = &interrupt_token;
+    std::signal(SIGINT, interrupt);
+    if (time_limit_ms > 0) {
+        fm_options.deadline = std::chrono::high_resolution_clock::now() + std::chrono::milliseconds(time_limit_ms);
+    }
+    if (!fixed_file_dir.empty()) {
+        // the recursive bisection renumbers the nodes of its subproblems, it cannot keep them fixed
+        if (kway_options.num_parts > 0) {
+            std::cerr << "Error: --fixed is not supported with --parts" << std::endl;
+            return 1;
+        }
+        std::string error;
+        if (!read_partition_file(fixed_file_dir, circuit.hypergraph(), fixed_part, error, false, 2)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+        fm_options.fixed_part = &fixed_part;
+    }
+    if (kway_options.num_parts > 0) {
+        kway_options.bisection.fm = fm_options;
+        KWayResult result = circuit.kway_partition(kway_options);
+        for (int part = 0; part < result.num_parts; part++) {
+            std::cout << "Part " << part << " size: " << result.part_weight[part] << std::endl;
+        }
+        std::cout << "Imbalance: " << result.imbalance << std::endl;
+        std::cout << "Total cut size: " << result.cut << ", connectivity: " << result.connectivity << std::endl;
+        if (hpwl) {
+            report_wirelength(hpwl_placement, &result.part, result.num_parts);
+        }
+        if (!write_results(result.part, result.num_parts)) {
+            return 1;
+        }
+        return write_metrics() ? 0 : 1;
+    }
+    CircuitPartition result;
+    std::vector<int> initial_partition;
+    if (!partition_file_dir.empty()) {
+        std::string error;
+        if (!read_partition_file(partition_file_dir, circuit.hypergraph(), initial_partition, error, true, 2)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+    }
+    if (!eco_file_dir.empty()) {
+        NetlistECO eco;
+        std::string error;
+        if (!read_eco(eco_file_dir, eco, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+        if (initial_partition.empty()) {
+            initial_partition = circuit.Fiduccia_Mattheyses_bipartition(fm_options).partition();
+        }
+        eco_options.fm = fm_options;
+        if (!circuit.apply_eco(eco, initial_partition, eco_options, result)) {
+            return 1;
+        }
+    }
+    else if (!initial_partition.empty()) {
+        result = circuit.warm_start_bipartition(std::move(initial_partition), fm_options);
+    }
+    else if (multilevel) {
+        MultilevelOptions multilevel_options;
+        multilevel_options.fm = fm_options;
+        result = circuit.multilevel_bipartition(multilevel_options);
+    }
+    else if (multi_start_options.num_starts > 0) {
+        multi_start_options.fm = fm_options;
+        result = circuit.multi_start_bipartition(multi_start_options);
+    }
+    else {
+        result = circuit.Fiduccia_Mattheyses_bipartition(fm_options);
+    }
     std::cout << "Partition 1:" << std::endl;
-    partition1.dump(dump_level);
+    result.view(0).dump(dump_level);
     std::cout << "Partition 2:" << std::endl;
-    partition2.dump(dump_level);
-    std::cout << "Total cut size: " << cut.size() << std::endl;
+    result.view(1).dump(dump_level);
+    std::cout << "Total cut size: " << result.cut_size() << std::endl;
+    if (hpwl) {
+        report_wirelength(hpwl_placement, &result.partition(), result.num_parts());
+    }
+    if (!write_results(result.partition(), result.num_parts())) {
+        return 1;
+    }
 
-    return 0;
+    return write_metrics() ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,535 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+#include "../include/annealing.h"
+
+AnnealingOptions::AnnealingOptions() : moves_per_node(10), initial_acceptance(0.9), cooling(0.9), min_acceptance(0.02), max_temperatures(150), swap_probability(0.5), bin_width(8), density_weight(40), legalize(true), seed(13), dump_level(0), metrics(nullptr) {}
+
+AnnealingPlacer::AnnealingPlacer(const Hypergraph& graph, Placement& placement, const AnnealingOptions& options) : graph(graph), options(options), placement(placement), rng(options.seed), hpwl(0), num_moved(0), core_x_min(0), core_x_max(0), bin_width(1), bins_per_row(1), overflow(0), density_weight(0), pending_hpwl(0), pending_overflow(0), mean_node_width(1), window_x(0), window_y(0) {
+    int num_nodes = graph.num_nodes();
+    int num_nets = graph.num_nets();
+    const std::vector<PlacementRow>& rows = placement.rows;
+    int num_rows = static_cast<int>(rows.size());
+    core_x_min = num_rows > 0 ? rows[0].x_min : 0;
+    core_x_max = num_rows > 0 ? rows[0].x_max : 0;
+    for (const PlacementRow& row : rows) {
+        core_x_min = std::min(core_x_min, row.x_min);
+        core_x_max = std::max(core_x_max, row.x_max);
+    }
+
+    // ## movable nodes, snapped to the sites of the nearest row they fit in
+    node_row.assign(num_nodes, -1);
+    double total_width = 0;
+    double total_area = 0;
+    for (int node = 0; node < num_nodes && num_rows > 0; node++) {
+        if (placement.fixed[node]) {
+            continue;
+        }
+        int upper = static_cast<int>(std::upper_bound(rows.begin(), rows.end(), placement.y[node], [](double y, const PlacementRow& row) { return y < row.y; }) - rows.begin());
+        int row = upper == 0 ? 0 : upper == num_rows || placement.y[node] - rows[upper - 1].y <= rows[upper].y - placement.y[node] ? upper - 1 : upper;
+        if (graph.node_height[node] > rows[row].height || graph.node_width[node] > rows[row].x_max - rows[row].x_min) {
+            continue;
+        }
+        movable.push_back(node);
+        node_row[node] = row;
+        placement.y[node] = rows[row].y;
+        placement.x[node] = _snap(row, placement.x[node], graph.node_width[node]);
+        total_width += graph.node_width[node];
+        total_area += graph.node_size[node];
+    }
+    mean_node_width = movable.empty() ? 1 : std::max(total_width / movable.size(), 1e-9);
+
+    // ## pins of every node, in net order, and their offsets from the lower left corner
+    pin_net.resize(graph.num_pins());
+    pin_offset_x.resize(graph.num_pins());
+    pin_offset_y.resize(graph.num_pins());
+    node_pin_offsets.assign(num_nodes + 1, 0);
+    for (int net = 0; net < num_nets; net++) {
+        for (int pin = graph.net_pin_offsets[net]; pin < graph.net_pin_offsets[net + 1]; pin++) {
+            int node = graph.pin_node[pin];
+            pin_net[pin] = net;
+            pin_offset_x[pin] = graph.node_width[node] / 2 + graph.pin_delta_width[pin];
+            pin_offset_y[pin] = graph.node_height[node] / 2 + graph.pin_delta_height[pin];
+            node_pin_offsets[node + 1]++;
+        }
+    }
+    std::partial_sum(node_pin_offsets.begin(), node_pin_offsets.end(), node_pin_offsets.begin());
+    node_pins.resize(graph.num_pins());
+    std::vector<int> fill(node_pin_offsets.begin(), node_pin_offsets.end() - 1);
+    for (int pin = 0; pin < graph.num_pins(); pin++) {
+        node_pins[fill[graph.pin_node[pin]]++] = pin;
+    }
+
+    // ## bounding boxes
+    boxes.resize(num_nets);
+    for (int net = 0; net < num_nets; net++) {
+        if (graph.net_pin_offsets[net + 1] - graph.net_pin_offsets[net] >= 2) {
+            _rescan(net, boxes[net]);
+            hpwl += boxes[net].hpwl();
+        }
+    }
+    net_stage.assign(num_nets, -1);
+
+    // ## density bins, the nodes that do not move take the sites they cover
+    bin_width = std::max(options.bin_width * mean_node_width, 1e-9);
+    bins_per_row = std::max(1, static_cast<int>(std::ceil((core_x_max - core_x_min) / bin_width)));
+    int num_bins = num_rows * bins_per_row;
+    bin_area.assign(num_bins, 0);
+    bin_capacity.assign(num_bins, 0);
+    bin_nodes.assign(num_bins, std::vector<int>());
+    for (int row = 0; row < num_rows; row++) {
+        for (int b = 0; b < bins_per_row; b++) {
+            double low = std::max(core_x_min + b * bin_width, rows[row].x_min);
+            double high = std::min(core_x_min + (b + 1) * bin_width, rows[row].x_max);
+            bin_capacity[row * bins_per_row + b] = std::max(0.0, high - low) * rows[row].height;
+        }
+    }
+    for (int node = 0; node < num_nodes && num_rows > 0; node++) {
+        if (node_row[node] >= 0 || graph.node_size[node] <= 0) {
+            continue;
+        }
+        double x_low = placement.x[node];
+        double x_high = x_low + graph.node_width[node];
+        double y_low = placement.y[node];
+        double y_high = y_low + graph.node_height[node];
+        int first_row = static_cast<int>(std::upper_bound(rows.begin(), rows.end(), y_low, [](double y, const PlacementRow& row) { return y < row.y; }) - rows.begin()) - 1;
+        for (int row = std::max(first_row, 0); row < num_rows && rows[row].y < y_high; row++) {
+            double y_overlap = std::min(y_high, rows[row].y + rows[row].height) - std::max(y_low, rows[row].y);
+            if (y_overlap <= 0) {
+                continue;
+            }
+            int first_bin = std::max(0, static_cast<int>((x_low - core_x_min) / bin_width));
+            for (int b = first_bin; b < bins_per_row && core_x_min + b * bin_width < x_high; b++) {
+                double x_overlap = std::min(x_high, core_x_min + (b + 1) * bin_width) - std::max(x_low, core_x_min + b * bin_width);
+                if (x_overlap > 0) {
+                    bin_capacity[row * bins_per_row + b] -= x_overlap * y_overlap;
+                }
+            }
+        }
+    }
+    node_bin.assign(num_nodes, -1);
+    node_slot.assign(num_nodes, -1);
+    for (int node : movable) {
+        int bin = _bin_of(node_row[node], placement.x[node], graph.node_width[node]);
+        node_bin[node] = bin;
+        node_slot[node] = static_cast<int>(bin_nodes[bin].size());
+        bin_nodes[bin].push_back(node);
+        bin_area[bin] += graph.node_size[node];
+    }
+    for (int bin = 0; bin < num_bins; bin++) {
+        bin_capacity[bin] = std::max(0.0, bin_capacity[bin]);
+        overflow += _bin_overflow(bin);
+    }
+    // one mean node area of overflow costs density_weight mean node widths of wirelength
+    double mean_node_area = movable.empty() ? 1 : std::max(total_area / movable.size(), 1e-9);
+    density_weight = options.density_weight * mean_node_width / mean_node_area;
+
+    window_x = core_x_max - core_x_min;
+    window_y = num_rows;
+}
+
+int AnnealingPlacer::_bin_of(int row, double x, double width) const {
+    int b = static_cast<int>((x + width / 2 - core_x_min) / bin_width);
+    return row * bins_per_row + std::min(std::max(b, 0), bins_per_row - 1);
+}
+
+double AnnealingPlacer::_snap(int row, double x, double width) const {
+    const PlacementRow& r = placement.rows[row];
+    x = std::min(std::max(x, r.x_min), r.x_max - width);
+    return r.x_min + std::floor((x - r.x_min) / r.site_spacing) * r.site_spacing;
+}
+
+void AnnealingPlacer::_rescan(int net, NetBox& box) const {
+    box = NetBox{1e300, -1e300, 1e300, -1e300, 0, 0, 0, 0};
+    for (int pin = graph.net_pin_offsets[net]; pin < graph.net_pin_offsets[net + 1]; pin++) {
+        int node = graph.pin_node[pin];
+        double x = placement.x[node] + pin_offset_x[pin];
+        double y = placement.y[node] + pin_offset_y[pin];
+        box.num_x_min = x < box.x_min ? 1 : box.num_x_min + (x == box.x_min);
+        box.x_min = std::min(box.x_min, x);
+        box.num_x_max = x > box.x_max ? 1 : box.num_x_max + (x == box.x_max);
+        box.x_max = std::max(box.x_max, x);
+        box.num_y_min = y < box.y_min ? 1 : box.num_y_min + (y == box.y_min);
+        box.y_min = std::min(box.y_min, y);
+        box.num_y_max = y > box.y_max ? 1 : box.num_y_max + (y == box.y_max);
+        box.y_max = std::max(box.y_max, y);
+    }
+}
+
+int AnnealingPlacer::_stage(int net) {
+    if (net_stage[net] < 0) {
+        net_stage[net] = static_cast<int>(staged_nets.size());
+        staged_nets.push_back(net);
+        staged_boxes.push_back(boxes[net]);
+        staged_rescan.push_back(false);
+    }
+    return net_stage[net];
+}
+
+void AnnealingPlacer::_stage_move(int node, double old_x, double old_y) {
+    for (int p = node_pin_offsets[node]; p < node_pin_offsets[node + 1]; p++) {
+        int pin = node_pins[p];
+        int net = pin_net[pin];
+        if (graph.net_pin_offsets[net + 1] - graph.net_pin_offsets[net] < 2) {
+            continue;
+        }
+        int s = _stage(net);
+        if (staged_rescan[s]) {
+            continue;
+        }
+        NetBox& box = staged_boxes[s];
+        // add the new pin position first, then remove the old one, a side left without pins needs a rescan
+        double x = placement.x[node] + pin_offset_x[pin];
+        double y = placement.y[node] + pin_offset_y[pin];
+        box.num_x_min = x < box.x_min ? 1 : box.num_x_min + (x == box.x_min);
+        box.x_min = std::min(box.x_min, x);
+        box.num_x_max = x > box.x_max ? 1 : box.num_x_max + (x == box.x_max);
+        box.x_max = std::max(box.x_max, x);
+        box.num_y_min = y < box.y_min ? 1 : box.num_y_min + (y == box.y_min);
+        box.y_min = std::min(box.y_min, y);
+        box.num_y_max = y > box.y_max ? 1 : box.num_y_max + (y == box.y_max);
+        box.y_max = std::max(box.y_max, y);
+        double old_pin_x = old_x + pin_offset_x[pin];
+        double old_pin_y = old_y + pin_offset_y[pin];
+        bool empty_side = (old_pin_x == box.x_min && --box.num_x_min == 0) | (old_pin_x == box.x_max && --box.num_x_max == 0)
+            | (old_pin_y == box.y_min && --box.num_y_min == 0) | (old_pin_y == box.y_max && --box.num_y_max == 0);
+        staged_rescan[s] = empty_side;
+    }
+}
+
+double AnnealingPlacer::_evaluate() {
+    for (int m = 0; m < num_moved; m++) {
+        _stage_move(moved[m].node, moved[m].old_x, moved[m].old_y);
+    }
+    pending_hpwl = 0;
+    for (int s = 0; s < static_cast<int>(staged_nets.size()); s++) {
+        int net = staged_nets[s];
+        if (staged_rescan[s]) {
+            _rescan(net, staged_boxes[s]);
+        }
+        pending_hpwl += staged_boxes[s].hpwl() - boxes[net].hpwl();
+    }
+    // overflow of the bins the moved nodes leave and enter, before and after the move
+    touched_bins.clear();
+    for (int m = 0; m < num_moved; m++) {
+        for (int bin : {moved[m].old_bin, moved[m].new_bin}) {
+            if (std::find(touched_bins.begin(), touched_bins.end(), bin) == touched_bins.end()) {
+                touched_bins.push_back(bin);
+            }
+        }
+    }
+    pending_overflow = 0;
+    for (int bin : touched_bins) {
+        pending_overflow -= _bin_overflow(bin);
+    }
+    for (int m = 0; m < num_moved; m++) {
+        bin_area[moved[m].old_bin] -= graph.node_size[moved[m].node];
+        bin_area[moved[m].new_bin] += graph.node_size[moved[m].node];
+    }
+    for (int bin : touched_bins) {
+        pending_overflow += _bin_overflow(bin);
+    }
+    return pending_hpwl + density_weight * pending_overflow;
+}
+
+void AnnealingPlacer::_commit() {
+    for (int s = 0; s < static_cast<int>(staged_nets.size()); s++) {
+        boxes[staged_nets[s]] = staged_boxes[s];
+        net_stage[staged_nets[s]] = -1;
+    }
+    staged_nets.clear();
+    staged_boxes.clear();
+    staged_rescan.clear();
+    hpwl += pending_hpwl;
+    overflow += pending_overflow;
+    for (int m = 0; m < num_moved; m++) {
+        const MovedNode& move = moved[m];
+        node_row[move.node] = move.new_row;
+        if (move.old_bin == move.new_bin) {
+            continue;
+        }
+        // unlink from the old bin by moving its last node into the slot
+        std::vector<int>& old_nodes = bin_nodes[move.old_bin];
+        int last = old_nodes.back();
+        old_nodes[node_slot[move.node]] = last;
+        node_slot[last] = node_slot[move.node];
+        old_nodes.pop_back();
+        node_bin[move.node] = move.new_bin;
+        node_slot[move.node] = static_cast<int>(bin_nodes[move.new_bin].size());
+        bin_nodes[move.new_bin].push_back(move.node);
+    }
+}
+
+void AnnealingPlacer::_undo() {
+    for (int net : staged_nets) {
+        net_stage[net] = -1;
+    }
+    staged_nets.clear();
+    staged_boxes.clear();
+    staged_rescan.clear();
+    for (int m = num_moved - 1; m >= 0; m--) {
+        placement.x[moved[m].node] = moved[m].old_x;
+        placement.y[moved[m].node] = moved[m].old_y;
+        bin_area[moved[m].old_bin] += graph.node_size[moved[m].node];
+        bin_area[moved[m].new_bin] -= graph.node_size[moved[m].node];
+    }
+}
+
+bool AnnealingPlacer::_propose() {
+    const std::vector<PlacementRow>& rows = placement.rows;
+    int a = movable[rng() % movable.size()];
+    int row_a = node_row[a];
+    int row = row_a + static_cast<int>(std::lround((2 * _uniform() - 1) * window_y));
+    row = std::min(std::max(row, 0), static_cast<int>(rows.size()) - 1);
+    double width = graph.node_width[a];
+    if (graph.node_height[a] > rows[row].height || width > rows[row].x_max - rows[row].x_min) {
+        return false;
+    }
+    double x = _snap(row, placement.x[a] + (2 * _uniform() - 1) * window_x, width);
+    int bin = _bin_of(row, x, width);
+    moved[0] = MovedNode{a, placement.x[a], placement.y[a], row_a, node_bin[a], row, bin};
+    num_moved = 1;
+    if (_uniform() < options.swap_probability && !bin_nodes[bin].empty()) {
+        // a takes the place of c and c the place of a, by their lower left corners
+        int c = bin_nodes[bin][rng() % bin_nodes[bin].size()];
+        int row_c = node_row[c];
+        if (c == a || graph.node_height[a] > rows[row_c].height || graph.node_height[c] > rows[row_a].height
+            || graph.node_width[c] > rows[row_a].x_max - rows[row_a].x_min || width > rows[row_c].x_max - rows[row_c].x_min) {
+            return false;
+        }
+        double x_a = _snap(row_c, placement.x[c], width);
+        double x_c = _snap(row_a, placement.x[a], graph.node_width[c]);
+        moved[0].new_row = row_c;
+        moved[0].new_bin = _bin_of(row_c, x_a, width);
+        moved[1] = MovedNode{c, placement.x[c], placement.y[c], row_c, node_bin[c], row_a, _bin_of(row_a, x_c, graph.node_width[c])};
+        num_moved = 2;
+        placement.x[a] = x_a;
+        placement.y[a] = rows[row_c].y;
+        placement.x[c] = x_c;
+        placement.y[c] = rows[row_a].y;
+        return true;
+    }
+    if (x == placement.x[a] && row == row_a) {
+        return false;
+    }
+    placement.x[a] = x;
+    placement.y[a] = rows[row].y;
+    return true;
+}
+
+AnnealingResult AnnealingPlacer::run() {
+    AnnealingResult result;
+    result.initial_hpwl = hpwl;
+    result.temperatures = 0;
+    result.moves = 0;
+    result.accepted = 0;
+    result.unplaced_nodes = 0;
+    result.anneal_ms = 0;
+    result.legalize_ms = 0;
+    result.moves_per_second = 0;
+    bool dump = options.dump_level == 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!movable.empty()) {
+        // ## initial temperature: the mean uphill move of a random sample is accepted with initial_acceptance
+        double uphill = 0;
+        int num_uphill = 0;
+        int samples = static_cast<int>(std::min<size_t>(20000, std::max<size_t>(100, movable.size())));
+        for (int i = 0; i < samples; i++) {
+            if (_propose()) {
+                double delta = _evaluate();
+                if (delta > 0) {
+                    uphill += delta;
+                    num_uphill++;
+                }
+                _undo();
+            }
+        }
+        double temperature = num_uphill > 0 ? -(uphill / num_uphill) / std::log(options.initial_acceptance) : 1e-9;
+        long long moves_per_temperature = std::max(1ll, static_cast<long long>(options.moves_per_node * movable.size()));
+        double max_window_x = core_x_max - core_x_min;
+        double max_window_y = static_cast<double>(placement.rows.size());
+        // ## temperatures
+        for (int t = 0; t < options.max_temperatures; t++) {
+            auto temperature_start = std::chrono::high_resolution_clock::now();
+            long long accepted = 0;
+            for (long long i = 0; i < moves_per_temperature; i++) {
+                if (!_propose()) {
+                    continue;
+                }
+                double delta = _evaluate();
+                if (delta <= 0 || _uniform() < std::exp(-delta / temperature)) {
+                    _commit();
+                    accepted++;
+                }
+                else {
+                    _undo();
+                }
+            }
+            // drop the rounding drift of the incremental sums
+            hpwl = 0;
+            for (int net = 0; net < graph.num_nets(); net++) {
+                hpwl += graph.net_pin_offsets[net + 1] - graph.net_pin_offsets[net] >= 2 ? boxes[net].hpwl() : 0;
+            }
+            overflow = 0;
+            for (int bin = 0; bin < static_cast<int>(bin_area.size()); bin++) {
+                overflow += _bin_overflow(bin);
+            }
+            auto temperature_end = std::chrono::high_resolution_clock::now();
+            double acceptance = static_cast<double>(accepted) / moves_per_temperature;
+            result.temperatures++;
+            result.moves += moves_per_temperature;
+            result.accepted += accepted;
+            if (dump) {
+                double ms = std::chrono::duration<double, std::milli>(temperature_end - temperature_start).count();
+                std::cout << "Temperature " << t << ": " << temperature << ", hpwl " << static_cast<long long>(hpwl) << ", overflow " << static_cast<long long>(overflow) << ", accepted " << 100 * acceptance << "%, window " << window_x << " x " << window_y << " rows, " << static_cast<long long>(moves_per_temperature / std::max(ms, 1e-3) * 1000) << " moves/s" << std::endl;
+            }
+            if (options.metrics != nullptr) {
+                options.metrics->record_phase("anneal_temperature", temperature_start, temperature_end);
+                options.metrics->sample("hpwl", hpwl);
+            }
+            // keep the acceptance near 0.44 by resizing the window
+            window_x = std::min(std::max(window_x * (0.56 + acceptance), 2 * mean_node_width), max_window_x);
+            window_y = std::min(std::max(window_y * (0.56 + acceptance), 1.0), max_window_y);
+            temperature *= options.cooling;
+            if (acceptance < options.min_acceptance) {
+                break;
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    result.anneal_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    result.moves_per_second = result.moves / std::max(result.anneal_ms, 1e-3) * 1000;
+    result.annealed_hpwl = hpwl;
+    result.hpwl = hpwl;
+    if (options.metrics != nullptr) {
+        options.metrics->record_phase("anneal", start, end);
+    }
+    if (options.legalize && !movable.empty()) {
+        start = std::chrono::high_resolution_clock::now();
+        _legalize(result);
+        end = std::chrono::high_resolution_clock::now();
+        result.legalize_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        result.hpwl = total_hpwl(graph, placement);
+        if (options.metrics != nullptr) {
+            options.metrics->record_phase("anneal_legalize", start, end);
+        }
+    }
+    if (dump) {
+        std::cout << "Annealing: hpwl " << static_cast<long long>(result.initial_hpwl) << " -> " << static_cast<long long>(result.annealed_hpwl) << " in " << result.temperatures << " temperatures, " << result.moves << " moves, " << result.accepted << " accepted, " << static_cast<long long>(result.moves_per_second) << " moves/s, " << static_cast<long long>(result.anneal_ms) << " ms" << std::endl;
+        if (options.legalize) {
+            std::cout << "Legalization: hpwl " << static_cast<long long>(result.hpwl) << ", " << result.unplaced_nodes << " nodes without free sites, " << static_cast<long long>(result.legalize_ms) << " ms" << std::endl;
+        }
+    }
+    return result;
+}
+
+// ## Tetris legalization: in order of x, every node goes to the free sites right of the frontier of a segment of a nearby row,
+// with the smallest displacement; the rows are split into segments around the nodes that do not move
+void AnnealingPlacer::_legalize(AnnealingResult& result) {
+    struct Segment {
+    public:
+        double x_min;
+        double x_max;
+        double frontier;
+    };
+    const std::vector<PlacementRow>& rows = placement.rows;
+    int num_rows = static_cast<int>(rows.size());
+    std::vector<std::vector<std::pair<double, double> > > blocked(num_rows);
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        if (node_row[node] >= 0 || graph.node_width[node] <= 0) {
+            continue;
+        }
+        double y_low = placement.y[node];
+        double y_high = y_low + graph.node_height[node];
+        int first_row = static_cast<int>(std::upper_bound(rows.begin(), rows.end(), y_low, [](double y, const PlacementRow& row) { return y < row.y; }) - rows.begin()) - 1;
+        for (int row = std::max(first_row, 0); row < num_rows && rows[row].y < y_high; row++) {
+            if (rows[row].y + rows[row].height > y_low) {
+                blocked[row].emplace_back(placement.x[node], placement.x[node] + graph.node_width[node]);
+            }
+        }
+    }
+    std::vector<std::vector<Segment> > segments(num_rows);
+    for (int row = 0; row < num_rows; row++) {
+        std::sort(blocked[row].begin(), blocked[row].end());
+        double x = rows[row].x_min;
+        for (const auto& block : blocked[row]) {
+            if (block.first > x) {
+                segments[row].push_back(Segment{x, std::min(block.first, rows[row].x_max), x});
+            }
+            x = std::max(x, block.second);
+        }
+        if (x < rows[row].x_max) {
+            segments[row].push_back(Segment{x, rows[row].x_max, x});
+        }
+    }
+
+    std::vector<int> order = movable;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return placement.x[a] < placement.x[b]; });
+    for (int node : order) {
+        double width = graph.node_width[node];
+        double x = placement.x[node];
+        double y = placement.y[node];
+        int home = node_row[node];
+        double best_cost = 1e300;
+        int best_row = -1;
+        int best_segment = -1;
+        double best_x = 0;
+        for (int d = 0; d < num_rows; d++) {
+            int candidates[2] = {home - d, d == 0 ? -1 : home + d};
+            double nearest = 1e300;
+            for (int row : candidates) {
+                if (row >= 0 && row < num_rows) {
+                    nearest = std::min(nearest, std::abs(rows[row].y - y));
+                }
+            }
+            if (nearest >= best_cost || (home - d < 0 && home + d >= num_rows)) {
+                break;
+            }
+            for (int row : candidates) {
+                if (row < 0 || row >= num_rows || graph.node_height[node] > rows[row].height) {
+                    continue;
+                }
+                // the nearest segment with room on each side of x, a node that does not fit at x goes left of it
+                std::vector<Segment>& row_segments = segments[row];
+                int first = static_cast<int>(std::partition_point(row_segments.begin(), row_segments.end(), [&](const Segment& segment) { return segment.x_max <= x; }) - row_segments.begin());
+                double spacing = rows[row].site_spacing;
+                auto try_segment = [&](int s) {
+                    const Segment& segment = row_segments[s];
+                    double position = std::max(segment.frontier, std::min(x, segment.x_max - width));
+                    position = rows[row].x_min + std::ceil((position - rows[row].x_min) / spacing) * spacing;
+                    if (position + width > segment.x_max) {
+                        return false;
+                    }
+                    double cost = std::abs(position - x) + std::abs(rows[row].y - y);
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        best_row = row;
+                        best_segment = s;
+                        best_x = position;
+                    }
+                    return true;
+                };
+                for (int s = first; s < static_cast<int>(row_segments.size()); s++) {
+                    if (try_segment(s)) {
+                        break;
+                    }
+                }
+                for (int s = first - 1; s >= 0; s--) {
+                    if (try_segment(s)) {
+                        break;
+                    }
+                }
+            }
+        }
+        if (best_row < 0) {
+            result.unplaced_nodes++;
+            continue;
+        }
+        placement.x[node] = best_x;
+        placement.y[node] = rows[best_row].y;
+        node_row[node] = best_row;
+        segments[best_row][best_segment].frontier = best_x + width;
+    }
+}
@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../include/bookshelf.h"
+#include "../include/text_io.h"
+#include "../include/thread_pool.h"
+
+namespace {
+
+// smallest chunk of a .nets file worth a thread of its own
+const size_t min_chunk_bytes = 1 << 20;
+
+// read the value of a "Key : value" header line, skipping the format line, comments and blank lines
+void read_header_count(TextScanner& scanner, std::string_view key, int& value, const std::string& file_dir) {
+    while (true) {
+        std::string_view t = scanner.token();
+        if (t.empty()) {
+            std::cerr << "Error: missing " << key << " in file " << file_dir << std::endl;
+            exit(1);
+        }
+        if (t[0] == '#' || t == "UCLA") {
+            scanner.skip_line();
+            continue;
+        }
+        // the colon and the value may be attached to the key
+        if (t.substr(0, key.size()) != key) {
+            std::cerr << "Error: expected " << key << " but found " << t << " in file " << file_dir << std::endl;
+            exit(1);
+        }
+        scanner.cur = t.data() + key.size();
+        scanner.skip_blanks();
+        if (scanner.cur < scanner.end && *scanner.cur == ':') {
+            scanner.cur++;
+        }
+        if (!scanner.parse_int(value)) {
+            std::cerr << "Error: cannot read " << key << " in file " << file_dir << std::endl;
+            exit(1);
+        }
+        return;
+    }
+}
+
+// nets parsed by one thread, names are views into the mapped file
+struct NetChunk {
+public:
+    const char* begin;
+    const char* end;
+    std::vector<std::string_view> net_names;
+    std::vector<int> net_degrees;
+    std::vector<int> pin_node;
+    std::vector<float> pin_delta_width;
+    std::vector<float> pin_delta_height;
+    const char* error_position; // where parsing failed, nullptr if it did not
+    std::string error;
+};
+
+// parse all the nets in [chunk.begin, chunk.end), each one like
+// NetDegree  :  9    n0
+//     o816034   I  :      0.0000     -1.5000
+//      p17299   I  :      0.0000      0.0000
+// the pin direction and the offsets are optional
+void parse_net_chunk(NetChunk& chunk, const NameTable& node_names) {
+    TextScanner scanner(chunk.begin, chunk.end);
+    // about 24 bytes per pin and 4 pins per net in superblue
+    size_t expected_pins = static_cast<size_t>(chunk.end - chunk.begin) / 24;
+    chunk.pin_node.reserve(expected_pins);
+    chunk.pin_delta_width.reserve(expected_pins);
+    chunk.pin_delta_height.reserve(expected_pins);
+    chunk.net_names.reserve(expected_pins / 4);
+    chunk.net_degrees.reserve(expected_pins / 4);
+    chunk.error_position = nullptr;
+    while (!scanner.at_end()) {
+        const char* net_position = scanner.cur;
+        std::string_view t = scanner.token();
+        // the colon and the degree may be attached to the keyword
+        if (t.substr(0, 9) != "NetDegree") {
+            chunk.error_position = net_position;
+            chunk.error = "expected NetDegree";
+            return;
+        }
+        scanner.cur = t.data() + 9;
+        scanner.skip_blanks();
+        if (scanner.cur < scanner.end && *scanner.cur == ':') {
+            scanner.cur++;
+        }
+        int degree;
+        if (!scanner.parse_int(degree) || degree < 0) {
+            chunk.error_position = net_position;
+            chunk.error = "cannot read the net degree";
+            return;
+        }
+        chunk.net_names.push_back(scanner.token_in_line());
+        chunk.net_degrees.push_back(degree);
+        for (int j = 0; j < degree; j++) {
+            scanner.skip_line();
+            const char* pin_position = scanner.cur;
+            std::string_view node_name = scanner.token();
+            int node = node_names.find(node_name);
+            if (node < 0) {
+                chunk.error_position = pin_position;
+                chunk.error = "unknown node " + std::string(node_name);
+                return;
+            }
+            float delta_width = 0;
+            float delta_height = 0;
+            // skip the direction, then read the offsets after the colon if there are any
+            scanner.token_in_line();
+            if (scanner.token_in_line() == ":" && !(scanner.parse_float(delta_width) && scanner.parse_float(delta_height))) {
+                chunk.error_position = pin_position;
+                chunk.error = "cannot read the pin offsets";
+                return;
+            }
+            chunk.pin_node.push_back(node);
+            chunk.pin_delta_width.push_back(delta_width);
+            chunk.pin_delta_height.push_back(delta_height);
+        }
+        scanner.skip_line();
+    }
+}
+
+// first "NetDegree" line at or after the line containing position
+const char* next_net_start(const char* position, const char* end) {
+    while (position < end) {
+        TextScanner line(position, end);
+        line.skip_blanks();
+        if (static_cast<size_t>(end - line.cur) >= 9 && std::memcmp(line.cur, "NetDegree", 9) == 0) {
+            return position;
+        }
+        line.skip_line();
+        position = line.cur;
+    }
+    return end;
+}
+
+} // namespace
+
+BookshelfFiles read_bookshelf_aux(const std::string& aux_file_dir) {
+    MappedFile aux_file;
+    if (!aux_file.open(aux_file_dir)) {
+        std::cerr << "Error: cannot open file " << aux_file_dir << std::endl;
+        exit(1);
+    }
+    std::string base = aux_file_dir.substr(0, aux_file_dir.find_last_of('.'));
+    std::string directory = aux_file_dir.find_last_of('/') == std::string::npos ? "" : aux_file_dir.substr(0, aux_file_dir.find_last_of('/') + 1);
+    BookshelfFiles files;
+    files.nodes = base + ".nodes";
+    files.nets = base + ".nets";
+    files.wts = base + ".wts";
+    files.pl = base + ".pl";
+    files.scl = base + ".scl";
+    TextScanner scanner(aux_file.begin(), aux_file.end());
+    for (std::string_view t = scanner.token(); !t.empty(); t = scanner.token()) {
+        size_t dot = t.find_last_of('.');
+        if (dot == std::string_view::npos) {
+            continue;
+        }
+        std::string_view extension = t.substr(dot + 1);
+        std::string file_dir = directory + std::string(t);
+        if (extension == "nodes") {
+            files.nodes = file_dir;
+        }
+        else if (extension == "nets") {
+            files.nets = file_dir;
+        }
+        else if (extension == "wts") {
+            files.wts = file_dir;
+        }
+        else if (extension == "pl") {
+            files.pl = file_dir;
+        }
+        else if (extension == "scl") {
+            files.scl = file_dir;
+        }
+    }
+    return files;
+}
+
+void load_bookshelf_nodes(const std::string& nodes_file_dir, Hypergraph& graph) {
+    MappedFile nodes_file;
+    if (!nodes_file.open(nodes_file_dir)) {
+        std::cerr << "Error: cannot open file " << nodes_file_dir << std::endl;
+        exit(1);
+    }
+    graph.clear();
+    TextScanner scanner(nodes_file.begin(), nodes_file.end());
+    // read line "NumNodes      :  847441" and line "NumTerminals  :  82339"
+    int num_vertices;
+    int num_terminals;
+    read_header_count(scanner, "NumNodes", num_vertices, nodes_file_dir);
+    read_header_count(scanner, "NumTerminals", num_terminals, nodes_file_dir);
+    graph.node_width.reserve(num_vertices);
+    graph.node_height.reserve(num_vertices);
+    graph.node_size.reserve(num_vertices);
+    graph.node_type.reserve(num_vertices);
+    graph.node_names.reserve(num_vertices, 8 * static_cast<size_t>(num_vertices));
+    // read num_vertices lines, each line is "o0 5 9" for a node, or "o765102 10 9 terminal" for a terminal
+    int terminals_found = 0;
+    for (int i = 0; i < num_vertices; i++) {
+        const char* line_position = scanner.cur;
+        std::string_view vertex_name = scanner.token();
+        double width;
+        double height;
+        if (vertex_name.empty() || !scanner.parse_double(width) || !scanner.parse_double(height)) {
+            std::cerr << "Error: cannot read node " << i << " at line " << line_number_of(nodes_file.begin(), line_position) << " of file " << nodes_file_dir << std::endl;
+            exit(1);
+        }
+        NodeTypeEnum node_type = NodeTypeEnum::node;
+        std::string_view type = scanner.token_in_line();
+        if (type == "terminal") {
+            node_type = NodeTypeEnum::terminal;
+            terminals_found++;
+        }
+        else if (type == "terminal_NI") {
+            node_type = NodeTypeEnum::terminal_nl;
+            terminals_found++;
+        }
+        // the nets refer to the nodes by name, a second definition would shadow the first one
+        if (graph.node_names.find(vertex_name) >= 0) {
+            std::cerr << "Error: node " << vertex_name << " defined twice at line " << line_number_of(nodes_file.begin(), line_position) << " of file " << nodes_file_dir << std::endl;
+            exit(1);
+        }
+        graph.add_node(vertex_name, width, height, node_type);
+        scanner.skip_line();
+    }
+    if (!scanner.at_end()) {
+        std::cerr << "Error: still exists some more content in file " << nodes_file_dir << std::endl;
+        exit(1);
+    }
+    if (terminals_found != num_terminals) {
+        std::cerr << "Error: NumTerminals is " << num_terminals << " but " << terminals_found << " terminals found in file " << nodes_file_dir << std::endl;
+        exit(1);
+    }
+}
+
+void load_bookshelf_nets(const std::string& nets_file_dir, Hypergraph& graph, int num_threads) {
+    MappedFile nets_file;
+    if (!nets_file.open(nets_file_dir)) {
+        std::cerr << "Error: cannot open file " << nets_file_dir << std::endl;
+        exit(1);
+    }
+    TextScanner scanner(nets_file.begin(), nets_file.end());
+    // read line "NumNets  :  822744" and line "NumPins  :  2861188"
+    int num_nets;
+    int num_pins;
+    read_header_count(scanner, "NumNets", num_nets, nets_file_dir);
+    read_header_count(scanner, "NumPins", num_pins, nets_file_dir);
+    scanner.skip_line();
+    const char* body = scanner.cur;
+
+    // split the body at NetDegree lines, one chunk per thread
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    size_t body_size = static_cast<size_t>(nets_file.end() - body);
+    int num_chunks = static_cast<int>(std::max<size_t>(1, std::min<size_t>(std::max(num_threads, 1), body_size / min_chunk_bytes)));
+    std::vector<NetChunk> chunks(num_chunks);
+    const char* chunk_begin = body;
+    for (int c = 0; c < num_chunks; c++) {
+        const char* chunk_end = c + 1 == num_chunks ? nets_file.end() : next_net_start(std::max(chunk_begin, body + body_size * (c + 1) / num_chunks), nets_file.end());
+        chunks[c].begin = chunk_begin;
+        chunks[c].end = chunk_end;
+        chunk_begin = chunk_end;
+    }
+
+    // parse the chunks, the node name index is only read by the threads
+    graph.node_names.build_index();
+    std::vector<std::thread> threads;
+    for (int c = 1; c < num_chunks; c++) {
+        threads.emplace_back(parse_net_chunk, std::ref(chunks[c]), std::cref(graph.node_names));
+    }
+    parse_net_chunk(chunks[0], graph.node_names);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // check the chunks, and compute where each of them goes in the pin arrays
+    std::vector<int> net_base(num_chunks + 1, 0);
+    std::vector<int> pin_base(num_chunks + 1, 0);
+    for (int c = 0; c < num_chunks; c++) {
+        if (chunks[c].error_position != nullptr) {
+            std::cerr << "Error: " << chunks[c].error << " at line " << line_number_of(nets_file.begin(), chunks[c].error_position) << " of file " << nets_file_dir << std::endl;
+            exit(1);
+        }
+        net_base[c + 1] = net_base[c] + static_cast<int>(chunks[c].net_degrees.size());
+        pin_base[c + 1] = pin_base[c] + static_cast<int>(chunks[c].pin_node.size());
+    }
+    if (net_base[num_chunks] != num_nets || pin_base[num_chunks] != num_pins) {
+        std::cerr << "Error: NumNets and NumPins are " << num_nets << " and " << num_pins << " but " << net_base[num_chunks] << " nets and " << pin_base[num_chunks] << " pins found in file " << nets_file_dir << std::endl;
+        exit(1);
+    }
+
+    // merge: every chunk copies its pins to its own range, in parallel
+    int first_net = graph.num_nets();
+    int first_pin = graph.num_pins();
+    graph.net_pin_offsets.resize(static_cast<size_t>(first_net) + num_nets + 1);
+    graph.pin_node.resize(static_cast<size_t>(first_pin) + num_pins);
+    graph.pin_delta_width.resize(static_cast<size_t>(first_pin) + num_pins);
+    graph.pin_delta_height.resize(static_cast<size_t>(first_pin) + num_pins);
+    auto copy_chunk = [&](int c) {
+        const NetChunk& chunk = chunks[c];
+        int offset = first_pin + pin_base[c];
+        int net = first_net + net_base[c];
+        for (int degree : chunk.net_degrees) {
+            offset += degree;
+            graph.net_pin_offsets[++net] = offset;
+        }
+        std::copy(chunk.pin_node.begin(), chunk.pin_node.end(), graph.pin_node.begin() + first_pin + pin_base[c]);
+        std::copy(chunk.pin_delta_width.begin(), chunk.pin_delta_width.end(), graph.pin_delta_width.begin() + first_pin + pin_base[c]);
+        std::copy(chunk.pin_delta_height.begin(), chunk.pin_delta_height.end(), graph.pin_delta_height.begin() + first_pin + pin_base[c]);
+    };
+    threads.clear();
+    for (int c = 1; c < num_chunks; c++) {
+        threads.emplace_back(copy_chunk, c);
+    }
+    copy_chunk(0);
+    // net names are appended meanwhile, they are rarely looked up so the index is only built on demand
+    size_t name_chars = 0;
+    for (const auto& chunk : chunks) {
+        for (std::string_view name : chunk.net_names) {
+            name_chars += name.size();
+        }
+    }
+    graph.net_names.drop_index();
+    graph.net_names.reserve(static_cast<size_t>(first_net) + num_nets, name_chars);
+    for (const auto& chunk : chunks) {
+        for (std::string_view name : chunk.net_names) {
+            if (name.empty()) {
+                // a net without a name is named after its id
+                graph.net_names.add("net" + std::to_string(graph.net_names.size()));
+            }
+            else {
+                graph.net_names.add(name);
+            }
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // build the node -> nets and net -> nodes incidence
+    graph.finalize();
+}
+
+bool write_bookshelf(const std::string& aux_file_dir, const Hypergraph& graph, std::string& error, int num_threads) {
+    std::string base = aux_file_dir.size() > 4 && aux_file_dir.compare(aux_file_dir.size() - 4, 4, ".aux") == 0 ? aux_file_dir.substr(0, aux_file_dir.size() - 4) : aux_file_dir;
+    std::string name = base.substr(base.find_last_of('/') == std::string::npos ? 0 : base.find_last_of('/') + 1);
+    std::unique_ptr<ThreadPool> pool;
+    if (num_threads != 1) {
+        pool = std::make_unique<ThreadPool>(num_threads);
+    }
+    TextWriter writer;
+    auto open = [&](const std::string& extension) {
+        if (!writer.open(base + extension)) {
+            error = "cannot open file " + base + extension;
+            return false;
+        }
+        return true;
+    };
+    auto close = [&](const std::string& extension) {
+        if (!writer.close()) {
+            error = "cannot write file " + base + extension;
+            return false;
+        }
+        return true;
+    };
+
+    if (!open(".aux")) {
+        return false;
+    }
+    writer << "RowBasedPlacement : " << name << ".nodes " << name << ".nets\n";
+    if (!close(".aux") || !open(".nodes")) {
+        return false;
+    }
+    int num_terminals = 0;
+    for (NodeTypeEnum node_type : graph.node_type) {
+        num_terminals += node_type != NodeTypeEnum::node;
+    }
+    writer << "UCLA nodes 1.0\n\nNumNodes : " << graph.num_nodes() << "\nNumTerminals : " << num_terminals << "\n\n";
+    write_parallel(writer, graph.num_nodes(), 16384, pool.get(), [&](TextBuffer& buffer, int begin, int end) {
+        for (int node = begin; node < end; node++) {
+            buffer << '\t' << graph.node_names[node] << '\t' << graph.node_width[node] << '\t' << graph.node_height[node];
+            buffer << (graph.node_type[node] == NodeTypeEnum::terminal ? "\tterminal\n" : graph.node_type[node] == NodeTypeEnum::terminal_nl ? "\tterminal_NI\n" : "\n");
+        }
+    });
+    if (!close(".nodes") || !open(".nets")) {
+        return false;
+    }
+    writer << "UCLA nets 1.0\n\nNumNets : " << graph.num_nets() << "\nNumPins : " << graph.num_pins() << "\n\n";
+    write_parallel(writer, graph.num_nets(), 8192, pool.get(), [&](TextBuffer& buffer, int begin, int end) {
+        for (int net = begin; net < end; net++) {
+            buffer << "NetDegree : " << graph.net_pin_offsets[net + 1] - graph.net_pin_offsets[net] << '\t' << graph.net_names[net] << '\n';
+            for (int pin = graph.net_pin_offsets[net]; pin < graph.net_pin_offsets[net + 1]; pin++) {
+                buffer << '\t' << graph.node_names[graph.pin_node[pin]] << " I : " << graph.pin_delta_width[pin] << ' ' << graph.pin_delta_height[pin] << '\n';
+            }
+        }
+    });
+    return close(".nets");
+}
@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <deque>
+
+#include "../include/eco.h"
+#include "../include/text_io.h"
+
+ECOOptions::ECOOptions() : radius(2), max_region_nodes(10000) {}
+
+bool read_eco(const std::string& eco_file_dir, NetlistECO& eco, std::string& error) {
+    MappedFile file;
+    if (!file.open(eco_file_dir)) {
+        error = "cannot open file " + eco_file_dir;
+        return false;
+    }
+    TextScanner scanner(file.begin(), file.end());
+    auto fail = [&](const std::string& message) {
+        error = message + " at line " + std::to_string(line_number_of(file.begin(), scanner.cur)) + " of file " + eco_file_dir;
+        return false;
+    };
+    while (!scanner.at_end()) {
+        std::string_view keyword = scanner.token();
+        if (keyword[0] == '#') {
+            scanner.skip_line();
+            continue;
+        }
+        if (scanner.token_in_line() != ":") {
+            return fail("expected : after " + std::string(keyword));
+        }
+        if (keyword == "AddNode") {
+            ECONode node;
+            node.name = std::string(scanner.token_in_line());
+            if (node.name.empty() || !scanner.parse_double(node.width) || !scanner.parse_double(node.height)) {
+                return fail("expected AddNode : <name> <width> <height>");
+            }
+            std::string_view type = scanner.token_in_line();
+            node.node_type = type == "terminal" ? NodeTypeEnum::terminal : type == "terminal_NI" ? NodeTypeEnum::terminal_nl : NodeTypeEnum::node;
+            eco.added_nodes.push_back(std::move(node));
+        }
+        else if (keyword == "RemoveNode") {
+            std::string_view name = scanner.token_in_line();
+            if (name.empty()) {
+                return fail("expected RemoveNode : <name>");
+            }
+            eco.removed_nodes.emplace_back(name);
+        }
+        else if (keyword == "AddNet") {
+            ECONet net;
+            int degree;
+            if (!scanner.parse_int(degree) || degree < 1) {
+                return fail("expected AddNet : <degree> <name>");
+            }
+            net.name = std::string(scanner.token_in_line());
+            for (int pin = 0; pin < degree; pin++) {
+                ECOPin eco_pin;
+                eco_pin.node = std::string(scanner.token());
+                eco_pin.delta_width = eco_pin.delta_height = 0;
+                // the direction and the offsets are optional, as in a .nets file
+                std::string_view t = scanner.token_in_line();
+                if (!t.empty() && t != ":") {
+                    t = scanner.token_in_line();
+                }
+                if (t == ":" && (!scanner.parse_float(eco_pin.delta_width) || !scanner.parse_float(eco_pin.delta_height))) {
+                    return fail("cannot read the pin offsets of net " + net.name);
+                }
+                if (eco_pin.node.empty()) {
+                    return fail("missing pins of net " + net.name);
+                }
+                net.pins.push_back(std::move(eco_pin));
+            }
+            eco.added_nets.push_back(std::move(net));
+        }
+        else if (keyword == "RemoveNet") {
+            std::string_view name = scanner.token_in_line();
+            if (name.empty()) {
+                return fail("expected RemoveNet : <name>");
+            }
+            eco.removed_nets.emplace_back(name);
+        }
+        else {
+            return fail("unknown ECO keyword " + std::string(keyword));
+        }
+        if (!scanner.at_line_end()) {
+            return fail("unexpected text after " + std::string(keyword));
+        }
+    }
+    return true;
+}
+
+bool apply_eco(const Hypergraph& graph, const NetlistECO& eco, ECOResult& result, std::string& error) {
+    // ## the removed ids, and the nets that lose pins with them
+    std::vector<char> node_removed(graph.num_nodes(), false);
+    std::vector<char> net_removed(graph.num_nets(), false);
+    std::vector<char> net_changed(graph.num_nets(), false);
+    for (const std::string& name : eco.removed_nodes) {
+        int node = graph.node_names.find(name);
+        if (node < 0) {
+            error = "cannot remove node " + name + ", it does not exist";
+            return false;
+        }
+        node_removed[node] = true;
+        for (int net : graph.nets_of(node)) {
+            net_changed[net] = true;
+        }
+    }
+    for (const std::string& name : eco.removed_nets) {
+        int net = graph.net_names.find(name);
+        if (net < 0) {
+            error = "cannot remove net " + name + ", it does not exist";
+            return false;
+        }
+        net_removed[net] = true;
+    }
+    for (const ECONode& node : eco.added_nodes) {
+        if (graph.node_names.find(node.name) >= 0 && !node_removed[graph.node_names.find(node.name)]) {
+            error = "cannot add node " + node.name + ", it already exists";
+            return false;
+        }
+    }
+
+    // ## copy the surviving nodes and pins, then append the additions
+    Hypergraph& updated = result.graph;
+    updated.clear();
+    updated.node_names.reserve(graph.num_nodes() + eco.added_nodes.size(), graph.node_names.characters().size());
+    result.old_to_new_node.assign(graph.num_nodes(), -1);
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        if (!node_removed[node]) {
+            result.old_to_new_node[node] = updated.add_node(graph.node_names[node], graph.node_width[node], graph.node_height[node], graph.node_type[node]);
+        }
+    }
+    // the names stay unique: the surviving nodes were checked above, the added ones are checked against each other here
+    for (const ECONode& node : eco.added_nodes) {
+        if (updated.node_names.find(node.name) >= 0) {
+            error = "cannot add node " + node.name + " twice";
+            return false;
+        }
+        updated.add_node(node.name, node.width, node.height, node.node_type);
+    }
+    result.num_added_nodes = static_cast<int>(eco.added_nodes.size());
+    // new ids of the changed nets, to find the touched nodes once the graph is finalized
+    std::vector<int> touched_nets;
+    for (int net = 0; net < graph.num_nets(); net++) {
+        if (net_removed[net]) {
+            continue;
+        }
+        bool has_pin = false;
+        for (int pin = graph.net_pin_offsets[net]; pin < graph.net_pin_offsets[net + 1]; pin++) {
+            int node = result.old_to_new_node[graph.pin_node[pin]];
+            if (node < 0) {
+                continue;
+            }
+            if (!has_pin) {
+                int id = updated.add_net(graph.net_names[net]);
+                if (net_changed[net]) {
+                    touched_nets.push_back(id);
+                }
+                has_pin = true;
+            }
+            updated.add_pin(node, graph.pin_delta_width[pin], graph.pin_delta_height[pin]);
+        }
+    }
+    // the removed nets touch the nodes that were on them
+    std::vector<int> touched_nodes;
+    for (const std::string& name : eco.removed_nets) {
+        for (int node : graph.nodes_of(graph.net_names.find(name))) {
+            if (result.old_to_new_node[node] >= 0) {
+                touched_nodes.push_back(result.old_to_new_node[node]);
+            }
+        }
+    }
+    for (const ECONet& net : eco.added_nets) {
+        // a surviving net or an earlier added net with the same name would make the names ambiguous
+        if (updated.net_names.find(net.name) >= 0) {
+            error = "cannot add net " + net.name + ", it already exists";
+            return false;
+        }
+        int id = updated.add_net(net.name);
+        touched_nets.push_back(id);
+        for (const ECOPin& pin : net.pins) {
+            int node = updated.node_names.find(pin.node);
+            if (node < 0) {
+                error = "net " + net.name + " has a pin on node " + pin.node + ", which does not exist";
+                return false;
+            }
+            updated.add_pin(node, pin.delta_width, pin.delta_height);
+        }
+    }
+    updated.finalize();
+
+    for (int net : touched_nets) {
+        for (int node : updated.nodes_of(net)) {
+            touched_nodes.push_back(node);
+        }
+    }
+    for (int node = updated.num_nodes() - result.num_added_nodes; node < updated.num_nodes(); node++) {
+        touched_nodes.push_back(node);
+    }
+    std::sort(touched_nodes.begin(), touched_nodes.end());
+    touched_nodes.erase(std::unique(touched_nodes.begin(), touched_nodes.end()), touched_nodes.end());
+    result.touched_nodes = std::move(touched_nodes);
+    return true;
+}
+
+std::vector<int> carry_partition(const ECOResult& result, const std::vector<int>& old_partition, int area_constraint) {
+    const Hypergraph& graph = result.graph;
+    std::vector<int> partition(graph.num_nodes(), 0);
+    double part_weight[2] = {0, 0};
+    for (int node = 0; node < static_cast<int>(old_partition.size()); node++) {
+        int id = result.old_to_new_node[node];
+        if (id >= 0) {
+            partition[id] = old_partition[node];
+            part_weight[partition[id]] += area_constraint == 0 ? 1.0 : graph.node_size[id];
+        }
+    }
+    // the added nodes follow the pins of their nets, the earlier added nodes count for the later ones
+    int first_added = graph.num_nodes() - result.num_added_nodes;
+    for (int node = first_added; node < graph.num_nodes(); node++) {
+        int pins[2] = {0, 0};
+        for (int net : graph.nets_of(node)) {
+            for (int other : graph.nodes_of(net)) {
+                if (other < node) {
+                    pins[partition[other]]++;
+                }
+            }
+        }
+        int part = pins[0] != pins[1] ? (pins[0] > pins[1] ? 0 : 1) : (part_weight[0] <= part_weight[1] ? 0 : 1);
+        partition[node] = part;
+        part_weight[part] += area_constraint == 0 ? 1.0 : graph.node_size[node];
+    }
+    return partition;
+}
+
+std::vector<int> eco_region(const Hypergraph& graph, const std::vector<int>& touched_nodes, const ECOOptions& options) {
+    // distance of every reached node, only the reached ones are written back
+    std::vector<int> region;
+    std::vector<int> distance;
+    std::vector<char> reached(graph.num_nodes(), false);
+    std::deque<int> queue;
+    for (int node : touched_nodes) {
+        if (!reached[node] && static_cast<int>(region.size()) < options.max_region_nodes) {
+            reached[node] = true;
+            region.push_back(node);
+            distance.push_back(0);
+            queue.push_back(static_cast<int>(region.size()) - 1);
+        }
+    }
+    while (!queue.empty() && static_cast<int>(region.size()) < options.max_region_nodes) {
+        int index = queue.front();
+        queue.pop_front();
+        int node = region[index];
+        int next_distance = distance[index] + 1;
+        if (next_distance > options.radius) {
+            continue;
+        }
+        for (int net : graph.nets_of(node)) {
+            if (graph.nodes_of(net).size() > options.fm.large_net_threshold) {
+                continue;
+            }
+            for (int other : graph.nodes_of(net)) {
+                if (!reached[other] && static_cast<int>(region.size()) < options.max_region_nodes) {
+                    reached[other] = true;
+                    region.push_back(other);
+                    distance.push_back(next_distance);
+                    queue.push_back(static_cast<int>(region.size()) - 1);
+                }
+            }
+        }
+    }
+    std::sort(region.begin(), region.end());
+    return region;
+}
+
+int incremental_refine(const Hypergraph& graph, std::vector<int>& partition, const std::vector<int>& region, const ECOOptions& options) {
+    FMBipartitioner bipartitioner(graph, options.fm);
+    bipartitioner.set_free_nodes(region);
+    return bipartitioner.run(partition);
+}
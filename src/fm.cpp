@@ -0,0 +1,557 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "../include/fm.h"
+
+namespace {
+
+// memory held by a buffer of FMScratch
+template <typename T>
+size_t capacity_bytes(const std::vector<T>& buffer) {
+    return buffer.capacity() * sizeof(T);
+}
+
+size_t capacity_bytes(const BucketArray& buffer) {
+    return buffer.capacity_bytes();
+}
+
+}
+
+void FMWorkspace::_account(FMScratch& buffers) {
+    size_t i = 0;
+    stats.scratch_bytes = 0;
+    buffers.for_each_buffer([&](const auto& buffer) {
+        size_t bytes = capacity_bytes(buffer);
+        if (i == buffer_bytes.size()) {
+            buffer_bytes.push_back(0);
+        }
+        stats.allocations += bytes > buffer_bytes[i];
+        buffer_bytes[i++] = bytes;
+        stats.scratch_bytes += bytes;
+    });
+    stats.peak_scratch_bytes = std::max(stats.peak_scratch_bytes, stats.scratch_bytes);
+}
+
+void FMWorkspace::release() {
+    scratch = FMScratch();
+    _account(scratch);
+}
+
+FMOptions::FMOptions() : area_constraint(1), max_unbalanced_nodes(500), max_imbalance(-1), target_fraction(0.5), max_passes(100), min_relative_improvement(0), large_net_policy(LargeNetPolicy::exact), large_net_threshold(1000), dump_level(0), progress_interval(100000), metrics(nullptr), num_threads(1), pool(nullptr), fix_terminals(false), fixed_part(nullptr), workspace(nullptr), deadline(std::chrono::high_resolution_clock::time_point::max()), max_moves(0), cancellation(nullptr), control_interval(1024) {}
+
+FMBipartitioner::FMBipartitioner(const Hypergraph& graph, FMOptions options) : graph(graph), options(options), pool(options.pool), workspace(options.workspace) {
+    if (pool == nullptr && options.num_threads != 1) {
+        own_pool = std::make_unique<ThreadPool>(options.num_threads);
+        pool = own_pool.get();
+    }
+    if (workspace == nullptr) {
+        own_workspace = std::make_unique<FMWorkspace>();
+        workspace = own_workspace.get();
+    }
+    if (workspace->in_use.exchange(true)) {
+        std::cerr << "Error: an FMWorkspace is used by two FMBipartitioner objects at once\n";
+        exit(1);
+    }
+    // take the buffers of the workspace, every one below is resized in place
+    workspace->stats.runs++;
+    std::swap(static_cast<FMScratch&>(*this), workspace->scratch);
+    int num_nodes = graph.num_nodes();
+    // the balance is measured in node sizes, or in number of nodes
+    if (options.area_constraint == 0) {
+        node_weight.assign(num_nodes, 1.0);
+    }
+    else {
+        node_weight.assign(graph.node_size.begin(), graph.node_size.end());
+    }
+    double max_node_weight = 0;
+    // pmax: a move changes the gain by at most the number of nets on the node
+    int max_degree = 0;
+    for (int node = 0; node < num_nodes; node++) {
+        max_node_weight = std::max(max_node_weight, node_weight[node]);
+        max_degree = std::max(max_degree, graph.nets_of(node).size());
+    }
+    max_imbalance = options.max_imbalance >= 0 ? options.max_imbalance : options.max_unbalanced_nodes * max_node_weight;
+    buckets[0].reset(max_degree, num_nodes);
+    buckets[1].reset(max_degree, num_nodes);
+    num_of_nodes_in_partition.assign(2 * static_cast<size_t>(graph.num_nets()), 0);
+    node_locked.assign(num_nodes, false);
+    large_net.assign(graph.num_nets(), false);
+    if (options.large_net_policy != LargeNetPolicy::exact) {
+        for (int net = 0; net < graph.num_nets(); net++) {
+            large_net[net] = graph.nodes_of(net).size() > options.large_net_threshold;
+        }
+    }
+    large_net_gain.assign(num_nodes, 0);
+    initial_gain.assign(num_nodes, 0);
+    move_log.clear();
+    free_nodes.clear();
+    node_fixed.clear();
+    movable_nodes.clear();
+    free_net_node_offsets.clear();
+    free_net_nodes.clear();
+    gain_update_visits = skipped_visits = 0;
+    partition_size[0] = partition_size[1] = 0;
+    target_size[0] = target_size[1] = 0;
+    cut_size = 0;
+    restricted = false;
+    run_moves = 0;
+    stopped = FMStopReason::none;
+
+    // ## fixed nodes, the gain updates walk the free nodes of every net only
+    if (options.fix_terminals || options.fixed_part != nullptr) {
+        // the fixed parts index the part sizes and the pin counters, only -1, 0 and 1 are valid
+        if (options.fixed_part != nullptr && static_cast<int>(options.fixed_part->size()) != num_nodes) {
+            std::cerr << "Error: the fixed parts have " << options.fixed_part->size() << " nodes, the hypergraph has " << num_nodes << "\n";
+            exit(1);
+        }
+        node_fixed.assign(num_nodes, false);
+        for (int node = 0; node < num_nodes; node++) {
+            if (options.fixed_part != nullptr && ((*options.fixed_part)[node] < -1 || (*options.fixed_part)[node] > 1)) {
+                std::cerr << "Error: node " << graph.node_names[node] << " is fixed in part " << (*options.fixed_part)[node] << ", a bipartition has parts 0 and 1\n";
+                exit(1);
+            }
+            node_fixed[node] = (options.fixed_part != nullptr && (*options.fixed_part)[node] >= 0) || (options.fix_terminals && graph.node_type[node] != NodeTypeEnum::node);
+            if (!node_fixed[node]) {
+                movable_nodes.push_back(node);
+            }
+        }
+        if (static_cast<int>(movable_nodes.size()) == num_nodes) {
+            node_fixed.clear();
+            movable_nodes.clear();
+        }
+    }
+    if (!node_fixed.empty()) {
+        free_net_node_offsets.assign(graph.num_nets() + 1, 0);
+        for (int net = 0; net < graph.num_nets(); net++) {
+            int num_free = 0;
+            for (int node : graph.nodes_of(net)) {
+                num_free += !node_fixed[node];
+            }
+            free_net_node_offsets[net + 1] = free_net_node_offsets[net] + num_free;
+        }
+        free_net_nodes.reserve(free_net_node_offsets.back());
+        for (int net = 0; net < graph.num_nets(); net++) {
+            for (int node : graph.nodes_of(net)) {
+                if (!node_fixed[node]) {
+                    free_net_nodes.push_back(node);
+                }
+            }
+        }
+    }
+    workspace->_account(*this);
+}
+
+FMBipartitioner::~FMBipartitioner() {
+    std::swap(static_cast<FMScratch&>(*this), workspace->scratch);
+    workspace->_account(workspace->scratch);
+    workspace->in_use.store(false);
+}
+
+FMStopReason FMBipartitioner::_check_stop(long long moves) const {
+    if (options.cancellation != nullptr && options.cancellation->is_cancelled()) {
+        return FMStopReason::cancelled;
+    }
+    if (options.max_moves > 0 && moves >= options.max_moves) {
+        return FMStopReason::move_budget;
+    }
+    if (options.deadline != std::chrono::high_resolution_clock::time_point::max() && std::chrono::high_resolution_clock::now() >= options.deadline) {
+        return FMStopReason::deadline;
+    }
+    return FMStopReason::none;
+}
+
+bool FMBipartitioner::_should_stop(int pass, long long moves, int cut, int best_cut) {
+    if (options.progress_callback) {
+        options.progress_callback(FMProgress{pass, moves, cut, best_cut, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - run_start).count()});
+    }
+    stopped = _check_stop(moves);
+    return stopped != FMStopReason::none;
+}
+
+void FMBipartitioner::_parallel_for(int end, const std::function<void(int, int)>& body) {
+    // chunks of a fixed size, small ones are not worth a task
+    const int grain = 16384;
+    if (pool == nullptr) {
+        body(0, end);
+    }
+    else {
+        pool->parallel_for(0, end, grain, body);
+    }
+}
+
+void FMBipartitioner::_initialize_counters() {
+    // partition sizes, serial so that the floating point sums do not depend on the threads
+    partition_size[0] = partition_size[1] = 0;
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        partition_size[partition[node]] += node_weight[node];
+    }
+    target_size[0] = (partition_size[0] + partition_size[1]) * options.target_fraction;
+    target_size[1] = partition_size[0] + partition_size[1] - target_size[0];
+    // count the number of nodes of each net in each partition, a net with nodes on both sides is a cut
+    // every net only writes its own counters, the cut is the sum of the cuts of the chunks
+    std::atomic<int> cut(0);
+    _parallel_for(graph.num_nets(), [&](int begin, int end) {
+        int chunk_cut = 0;
+        for (int net = begin; net < end; net++) {
+            int* counter = &num_of_nodes_in_partition[2 * net];
+            counter[0] = counter[1] = 0;
+            for (int node : graph.nodes_of(net)) {
+                counter[partition[node]]++;
+            }
+            if (counter[0] > 0 && counter[1] > 0) {
+                chunk_cut++;
+            }
+        }
+        cut += chunk_cut;
+    });
+    cut_size = cut;
+}
+
+int FMBipartitioner::_compute_gain(int node) {
+    int part = partition[node];
+    int gain = 0;
+    large_net_gain[node] = 0;
+    // go through all the nets this node is involved in
+    for (int net : graph.nets_of(node)) {
+        int net_gain = 0;
+        // if this net has only one node in the node's partition, increase gain
+        if (num_of_nodes_in_partition[2 * net + part] == 1) {
+            net_gain++;
+        }
+        // if this net has nothing on the other side, decrease gain
+        if (num_of_nodes_in_partition[2 * net + 1 - part] == 0) {
+            net_gain--;
+        }
+        if (!large_net[net]) {
+            gain += net_gain;
+        }
+        else if (options.large_net_policy == LargeNetPolicy::counter_only) {
+            large_net_gain[node] += net_gain;
+        }
+    }
+    return gain + large_net_gain[node];
+}
+
+void FMBipartitioner::_initialize_gains() {
+    if (restricted) {
+        // only the free nodes enter the buckets, take out the ones the last pass left there
+        for (int node : free_nodes) {
+            if (buckets[partition[node]].contains(node)) {
+                buckets[partition[node]].erase(node);
+            }
+            node_locked[node] = false;
+        }
+        for (int node : free_nodes) {
+            buckets[partition[node]].insert(node, _compute_gain(node));
+        }
+        return;
+    }
+    buckets[0].reset(buckets[0].max_gain_bound(), graph.num_nodes());
+    buckets[1].reset(buckets[1].max_gain_bound(), graph.num_nodes());
+    // all the nodes, or the movable ones if some are fixed
+    bool all_free = node_fixed.empty();
+    int num_free = all_free ? graph.num_nodes() : static_cast<int>(movable_nodes.size());
+    // every node only writes its own gains
+    _parallel_for(num_free, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            int node = all_free ? i : movable_nodes[i];
+            node_locked[node] = false;
+            initial_gain[node] = _compute_gain(node);
+        }
+    });
+    // the insertion order decides the ties between equal gains, keep it serial
+    for (int i = 0; i < num_free; i++) {
+        int node = all_free ? i : movable_nodes[i];
+        buckets[partition[node]].insert(node, initial_gain[node]);
+    }
+}
+
+void FMBipartitioner::set_free_nodes(std::vector<int> nodes) {
+    restricted = true;
+    free_nodes.assign(nodes.begin(), nodes.end());
+    if (!node_fixed.empty()) {
+        free_nodes.erase(std::remove_if(free_nodes.begin(), free_nodes.end(), [&](int node) { return node_fixed[node]; }), free_nodes.end());
+    }
+    std::fill(node_locked.begin(), node_locked.end(), true);
+}
+
+template <bool with_metrics>
+void FMBipartitioner::_move(int node, bool update_gains) {
+    int from_part = partition[node];
+    int to_part = 1 - from_part;
+    partition[node] = to_part;
+    partition_size[from_part] -= node_weight[node];
+    partition_size[to_part] += node_weight[node];
+    // go through all the nets this node is involved in, check critical nets, update gains and num_of_nodes_in_partition
+    for (int net : graph.nets_of(node)) {
+        int* counter = &num_of_nodes_in_partition[2 * net];
+        if (!update_gains) {
+            counter[from_part]--;
+            counter[to_part]++;
+            continue;
+        }
+        // the fixed nodes of the net are never visited
+        int net_size = _free_nodes_of(net).size();
+        if (large_net[net]) {
+            // the gains do not follow this net, keep the cut exact from the counters
+            bool was_cut = counter[0] > 0 && counter[1] > 0;
+            skipped_visits += static_cast<long long>(net_size) * ((counter[to_part] <= 1) + (counter[from_part] <= 2));
+            counter[from_part]--;
+            counter[to_part]++;
+            cut_size += (counter[0] > 0 && counter[1] > 0) - was_cut;
+            continue;
+        }
+        gain_update_visits += static_cast<long long>(net_size) * ((counter[to_part] <= 1) + (counter[from_part] <= 2));
+        if (with_metrics) {
+            metrics_block.count(MetricCounter::nets_touched);
+            metrics_block.count(MetricCounter::gain_updates, static_cast<long long>(net_size) * ((counter[to_part] <= 1) + (counter[from_part] <= 2)));
+            metrics_block.observe(MetricHistogram::net_degree_touched, net_size);
+        }
+        // check critical nets before the move
+        // T(n) == 0 then increase gain of all free cells on this net
+        if (counter[to_part] == 0) {
+            for (int other : _free_nodes_of(net)) {
+                if (!node_locked[other]) {
+                    buckets[partition[other]].increase_gain(other);
+                    if (with_metrics) {
+                        metrics_block.count(MetricCounter::bucket_reinserts);
+                    }
+                }
+            }
+        }
+        // else of T(n) == 1 THEN decrement gain of the only T cell on net(n), if it is free
+        else if (counter[to_part] == 1) {
+            for (int other : _free_nodes_of(net)) {
+                if (!node_locked[other] && partition[other] == to_part) {
+                    buckets[to_part].decrease_gain(other);
+                    if (with_metrics) {
+                        metrics_block.count(MetricCounter::bucket_reinserts);
+                    }
+                }
+            }
+        }
+        // update the num_of_nodes_in_partition to reflect the movement
+        counter[from_part]--;
+        counter[to_part]++;
+        // check critical nets after the move
+        // F(n) == 0 then decrease gain of all free cells on this net
+        if (counter[from_part] == 0) {
+            for (int other : _free_nodes_of(net)) {
+                if (!node_locked[other]) {
+                    buckets[partition[other]].decrease_gain(other);
+                    if (with_metrics) {
+                        metrics_block.count(MetricCounter::bucket_reinserts);
+                    }
+                }
+            }
+        }
+        // ELSE IF F(n) = 1 THEN increment gain of the only F cell on net(n), if it is free
+        else if (counter[from_part] == 1) {
+            for (int other : _free_nodes_of(net)) {
+                if (!node_locked[other] && partition[other] == from_part) {
+                    buckets[from_part].increase_gain(other);
+                    if (with_metrics) {
+                        metrics_block.count(MetricCounter::bucket_reinserts);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <bool with_metrics>
+FMPassStats FMBipartitioner::_pass(int pass) {
+    auto start = std::chrono::high_resolution_clock::now();
+    FMPassStats pass_stats;
+    pass_stats.pass = pass;
+    pass_stats.cut_before = cut_size;
+
+    _initialize_gains();
+    auto end_gain_init = std::chrono::high_resolution_clock::now();
+    move_log.clear();
+    gain_update_visits = skipped_visits = 0;
+    // best prefix of the move log, and its cut size
+    int min_cut_size = cut_size;
+    int best_prefix = 0;
+    while (true) {
+        int max_gain_index[2];
+        if (with_metrics) {
+            max_gain_index[0] = buckets[0].max_gain_index();
+            max_gain_index[1] = buckets[1].max_gain_index();
+        }
+        bool eligible_for_move[2] = {false, false};
+        // find the max gain nodes of each part
+        for (int part = 0; part < 2; part++) {
+            // node exists in the bucket
+            eligible_for_move[part] = !buckets[part].is_empty()
+            // remove the max gain node will not cause the partition too small
+            && partition_size[part] - node_weight[buckets[part].get_max_gain_node()] >= target_size[part] - max_imbalance
+            // add the max gain node will not cause the partition too large
+            && partition_size[1-part] + node_weight[buckets[part].get_max_gain_node()] <= target_size[1-part] + max_imbalance;
+        }
+        int from_part;
+        // if neither eligible for move, finished, break
+        if (!eligible_for_move[0] && !eligible_for_move[1]) {
+            break;
+        }
+        // if only one part is eligible for move, move from this part
+        else if (eligible_for_move[0] && !eligible_for_move[1]) {
+            from_part = 0;
+        }
+        else if (!eligible_for_move[0] && eligible_for_move[1]) {
+            from_part = 1;
+        }
+        // if both parts are eligible for move, choose the one with the max gain node
+        else {
+            from_part = buckets[0].get_max_gain() >= buckets[1].get_max_gain() ? 0 : 1;
+        }
+        int node_to_move = buckets[from_part].get_max_gain_node();
+        if (with_metrics) {
+            // the max gain lookups above stepped the max gain index down over the empty lists
+            metrics_block.count(MetricCounter::max_gain_rescans, max_gain_index[0] - buckets[0].max_gain_index() + max_gain_index[1] - buckets[1].max_gain_index());
+            metrics_block.count(MetricCounter::moves);
+            metrics_block.observe(MetricHistogram::move_gain, buckets[from_part].gain(node_to_move) - large_net_gain[node_to_move]);
+        }
+
+        // excute movement, the large nets update the cut in _move
+        cut_size -= buckets[from_part].gain(node_to_move) - large_net_gain[node_to_move];
+        buckets[from_part].erase(node_to_move);
+        node_locked[node_to_move] = true;
+        _move<with_metrics>(node_to_move, true);
+        move_log.push_back(node_to_move);
+
+        // remember the best prefix of the move log
+        if (cut_size < min_cut_size) {
+            min_cut_size = cut_size;
+            best_prefix = static_cast<int>(move_log.size());
+        }
+
+        // the budget is a comparison, the other controls read the clock and the token, once in a while
+        long long moves = run_moves + static_cast<long long>(move_log.size());
+        if (options.max_moves > 0 && moves >= options.max_moves) {
+            stopped = FMStopReason::move_budget;
+            break;
+        }
+        if (options.control_interval > 0 && move_log.size() % options.control_interval == 0 && _should_stop(pass, moves, cut_size, min_cut_size)) {
+            break;
+        }
+
+        // sampled progress, every progress_interval moves
+        if ((options.dump_level == 1 || with_metrics) && options.progress_interval > 0 && move_log.size() % options.progress_interval == 0) {
+            if (options.dump_level == 1) {
+                std::cout << "FM pass " << pass << ", move " << move_log.size() << ": last node " << graph.node_names[node_to_move] << ", cut " << cut_size << ", min cut " << min_cut_size << ", partition size " << partition_size[0] << ", " << partition_size[1] << ", " << static_cast<long long>(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count()) << " ms" << std::endl;
+            }
+            if (with_metrics) {
+                options.metrics->sample("cut", cut_size);
+            }
+        }
+    }
+
+    // roll back the moves after the best prefix, the gains are rebuilt by the next pass
+    run_moves += static_cast<long long>(move_log.size());
+    for (int i = static_cast<int>(move_log.size()) - 1; i >= best_prefix; i--) {
+        _move<with_metrics>(move_log[i], false);
+    }
+    cut_size = min_cut_size;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    pass_stats.moves = static_cast<int>(move_log.size());
+    pass_stats.best_prefix = best_prefix;
+    pass_stats.cut_after = cut_size;
+    pass_stats.gain_update_visits = gain_update_visits;
+    pass_stats.skipped_visits = skipped_visits;
+    pass_stats.gain_init_ms = std::chrono::duration<double, std::milli>(end_gain_init - start).count();
+    pass_stats.time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    if (with_metrics) {
+        options.metrics->merge(metrics_block);
+        metrics_block.clear();
+        options.metrics->record_phase("fm_gain_init", start, end_gain_init);
+        options.metrics->record_phase("fm_pass", start, end);
+        options.metrics->sample("cut", cut_size);
+    }
+    return pass_stats;
+}
+
+int FMBipartitioner::run(std::vector<int>& initial_partition) {
+    auto start = std::chrono::high_resolution_clock::now(); // track time
+    run_start = start;
+    run_moves = 0;
+    stopped = FMStopReason::none;
+    partition = initial_partition;
+    // the fixed nodes with a given part go there, the others keep their initial part
+    if (!node_fixed.empty() && options.fixed_part != nullptr) {
+        for (int node = 0; node < graph.num_nodes(); node++) {
+            if ((*options.fixed_part)[node] >= 0) {
+                partition[node] = (*options.fixed_part)[node];
+            }
+        }
+    }
+    _initialize_counters();
+    // check balance condition for initial partition
+    if (partition_size[0] > target_size[0] + max_imbalance || partition_size[0] < target_size[0] - max_imbalance) {
+        std::cerr << "Error: the initial partition is unbalanced, please check the input parameters\n";
+        std::cerr << "Partition size: " << partition_size[0] << " , " << partition_size[1] << ", target size: " << target_size[0] << " , " << target_size[1] << ", max imbalance: " << max_imbalance << std::endl;
+        exit(1);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    if (options.dump_level == 0) {
+        std::cout << "Time to initialize in FM algo: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+    }
+    if (options.metrics != nullptr) {
+        options.metrics->record_phase("fm_init", start, end);
+    }
+
+    auto start_main_loop = std::chrono::high_resolution_clock::now();
+    stats.clear();
+    for (int pass = 1; pass <= options.max_passes; pass++) {
+        // a pass stopped by the controls sets stopped itself, the deadline may also pass between two passes
+        stopped = stopped != FMStopReason::none ? stopped : _check_stop(run_moves);
+        if (stopped != FMStopReason::none) {
+            break;
+        }
+        FMPassStats pass_stats = options.metrics != nullptr ? _pass<true>(pass) : _pass<false>(pass);
+        stats.push_back(pass_stats);
+        if (options.dump_level == 0) {
+            std::cout << "FM pass " << pass << ": " << pass_stats.moves << " moves, best prefix " << pass_stats.best_prefix << ", cut " << pass_stats.cut_before << " -> " << pass_stats.cut_after << ", " << static_cast<long long>(pass_stats.time_ms) << " ms" << std::endl;
+        }
+        if (options.progress_callback) {
+            options.progress_callback(FMProgress{pass, run_moves, cut_size, cut_size, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - run_start).count()});
+        }
+        // stop on no improvement, or on an improvement below the threshold
+        int improvement = pass_stats.cut_before - pass_stats.cut_after;
+        if (stopped != FMStopReason::none || improvement <= 0 || improvement < options.min_relative_improvement * pass_stats.cut_before) {
+            break;
+        }
+        if (pass_callback && !pass_callback(pass_stats)) {
+            break;
+        }
+    }
+    if (stopped != FMStopReason::none && options.dump_level == 0) {
+        std::cout << "FM stopped by the " << (stopped == FMStopReason::deadline ? "deadline" : stopped == FMStopReason::move_budget ? "move budget" : "cancellation") << " after " << run_moves << " moves, cut " << cut_size << std::endl;
+    }
+    auto end_main_loop = std::chrono::high_resolution_clock::now();
+    if (options.dump_level == 0) {
+        std::cout << "Time to run main loop in FM algo: " << std::chrono::duration_cast<std::chrono::milliseconds>(end_main_loop - start_main_loop).count() << " ms" << std::endl;
+        if (options.large_net_policy != LargeNetPolicy::exact) {
+            long long visits = 0;
+            long long skipped = 0;
+            for (const FMPassStats& pass_stats : stats) {
+                visits += pass_stats.gain_update_visits;
+                skipped += pass_stats.skipped_visits;
+            }
+            std::cout << "Large nets: " << std::count(large_net.begin(), large_net.end(), true) << " nets with more than " << options.large_net_threshold << " nodes, skipped " << skipped << " of " << visits + skipped << " gain update pin visits (" << (visits + skipped > 0 ? 100.0 * skipped / (visits + skipped) : 0.0) << "%)" << std::endl;
+        }
+    }
+
+    workspace->_account(*this);
+    if (options.dump_level == 0 && options.workspace != nullptr) {
+        const FMWorkspaceStats& workspace_stats = workspace->statistics();
+        std::cout << "FM workspace: " << workspace_stats.runs << " runs, " << workspace_stats.allocations << " buffer allocations, " << workspace_stats.scratch_bytes << " bytes of scratch, peak " << workspace_stats.peak_scratch_bytes << " bytes" << std::endl;
+    }
+
+    initial_partition = partition;
+    return cut_size;
+}
@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../include/generator.h"
+#include "../include/text_io.h"
+
+GeneratorOptions::GeneratorOptions() : num_nodes(10000), num_nets(10000), num_pins(0), degree_exponent(2.5), max_net_degree(1000), terminal_fraction(0.05), macro_fraction(0.001), macro_scale(500), row_height(9), locality(0.9), locality_window(50), utilization(0.7), seed(13) {}
+
+namespace {
+// ## deterministic netlist source shared by generate_hypergraph and generate_bookshelf
+// node sizes and net degrees are drawn up front, the pins of the nets are drawn one net at a time
+class NetlistGenerator {
+private:
+    const GeneratorOptions& options;
+    std::mt19937_64 net_rng;
+    std::vector<int> last_net; // node id -> last net that got a pin on the node, to keep the nodes of a net distinct
+    int next;
+public:
+    std::vector<float> width;
+    std::vector<float> height;
+    int num_movable;
+    int num_macros;
+    std::vector<int> degree; // net id -> number of pins
+    long long num_pins;
+    double movable_area;
+    std::string error;
+
+    explicit NetlistGenerator(const GeneratorOptions& options);
+    // nodes and pin offsets of the next net
+    void next_net(std::vector<int>& nodes, std::vector<float>& delta_width, std::vector<float>& delta_height);
+    GeneratorStats stats() const;
+};
+
+// mean of the degree distribution P(d) ~ d^-exponent on [2, max_degree]
+double mean_degree(double exponent, int max_degree) {
+    double weight_sum = 0;
+    double degree_sum = 0;
+    for (int d = 2; d <= max_degree; d++) {
+        double weight = std::pow(d, -exponent);
+        weight_sum += weight;
+        degree_sum += d * weight;
+    }
+    return degree_sum / weight_sum;
+}
+
+NetlistGenerator::NetlistGenerator(const GeneratorOptions& options) : options(options), net_rng(options.seed ^ 0x6E657473ull), next(0), num_movable(0), num_macros(0), num_pins(0), movable_area(0) {
+    int num_nodes = options.num_nodes;
+    int max_degree = std::min(options.max_net_degree, num_nodes);
+    if (num_nodes < 2 || options.num_nets < 0 || max_degree < 2) {
+        error = "at least 2 nodes, no negative net count and a max net degree of at least 2 are needed";
+        return;
+    }
+    if (options.num_pins != 0 && (options.num_pins < 2ll * options.num_nets || options.num_pins > static_cast<long long>(max_degree) * options.num_nets)) {
+        error = "the number of pins must be between 2 and " + std::to_string(max_degree) + " times the number of nets";
+        return;
+    }
+
+    // ## nodes: standard cells of one row height, a few macros, terminals at the end
+    std::mt19937_64 node_rng(options.seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    int num_terminals = std::min(num_nodes - 1, static_cast<int>(std::lround(options.terminal_fraction * num_nodes)));
+    num_movable = num_nodes - num_terminals;
+    width.resize(num_nodes);
+    height.resize(num_nodes);
+    // standard cell widths 2 .. 16 sites, mean 9
+    double mean_cell_area = 9 * options.row_height;
+    for (int node = 0; node < num_nodes; node++) {
+        if (node < num_movable && uniform(node_rng) < options.macro_fraction) {
+            // macro: a whole number of rows high, about square
+            double area = options.macro_scale * mean_cell_area * (0.5 + 1.5 * uniform(node_rng));
+            height[node] = static_cast<float>(options.row_height * std::max(2.0, std::round(std::sqrt(area) / options.row_height)));
+            width[node] = static_cast<float>(std::max(1.0, std::round(area / height[node])));
+            num_macros++;
+        }
+        else {
+            width[node] = static_cast<float>(2 + node_rng() % 15);
+            height[node] = static_cast<float>(options.row_height);
+        }
+        if (node < num_movable) {
+            movable_area += static_cast<double>(width[node]) * height[node];
+        }
+    }
+
+    // ## net degrees: power law, with the exponent tuned so that the mean degree meets the pin count
+    double exponent = options.degree_exponent;
+    if (options.num_pins != 0 && options.num_nets > 0) {
+        double target_mean = static_cast<double>(options.num_pins) / options.num_nets;
+        // the mean decreases with the exponent
+        double low = -4;
+        double high = 20;
+        for (int iteration = 0; iteration < 60; iteration++) {
+            double middle = (low + high) / 2;
+            if (mean_degree(middle, max_degree) > target_mean) {
+                low = middle;
+            }
+            else {
+                high = middle;
+            }
+        }
+        exponent = (low + high) / 2;
+    }
+    std::vector<double> cumulative(max_degree - 1);
+    double sum = 0;
+    for (int d = 2; d <= max_degree; d++) {
+        sum += std::pow(d, -exponent);
+        cumulative[d - 2] = sum;
+    }
+    degree.resize(options.num_nets);
+    for (int& d : degree) {
+        double u = uniform(net_rng) * sum;
+        d = 2 + static_cast<int>(std::lower_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin());
+        d = std::min(d, max_degree);
+        num_pins += d;
+    }
+    // hit the pin count exactly with unit steps on random nets
+    if (options.num_pins != 0) {
+        while (num_pins != options.num_pins) {
+            int& d = degree[net_rng() % degree.size()];
+            if (num_pins < options.num_pins && d < max_degree) {
+                d++;
+                num_pins++;
+            }
+            else if (num_pins > options.num_pins && d > 2) {
+                d--;
+                num_pins--;
+            }
+        }
+    }
+    last_net = std::vector<int>(num_nodes, -1);
+}
+
+void NetlistGenerator::next_net(std::vector<int>& nodes, std::vector<float>& delta_width, std::vector<float>& delta_height) {
+    int net = next++;
+    nodes.clear();
+    delta_width.clear();
+    delta_height.clear();
+    int num_nodes = static_cast<int>(width.size());
+    int d = degree[net];
+    std::uniform_real_distribution<double> uniform(0, 1);
+    int center = static_cast<int>(net_rng() % num_movable);
+    long long window = std::max(options.locality_window, d);
+    for (int pin = 0; pin < d; pin++) {
+        int node;
+        int tries = 0;
+        do {
+            // after a few collisions, fall back to a node anywhere, which always finds a free one
+            if (tries++ < 32 && uniform(net_rng) < options.locality) {
+                long long offset = static_cast<long long>(net_rng() % (2 * window + 1)) - window;
+                node = static_cast<int>(((center + offset) % num_movable + num_movable) % num_movable);
+            }
+            else {
+                node = static_cast<int>(net_rng() % num_nodes);
+            }
+        } while (last_net[node] == net);
+        last_net[node] = net;
+        nodes.push_back(node);
+        // pin offsets from the node center, on a half unit grid inside the node
+        delta_width.push_back(static_cast<float>(std::round((uniform(net_rng) - 0.5) * width[node] * 2) / 2));
+        delta_height.push_back(static_cast<float>(std::round((uniform(net_rng) - 0.5) * height[node] * 2) / 2));
+    }
+}
+
+GeneratorStats NetlistGenerator::stats() const {
+    GeneratorStats stats;
+    stats.num_nodes = static_cast<int>(width.size());
+    stats.num_terminals = stats.num_nodes - num_movable;
+    stats.num_macros = num_macros;
+    stats.num_nets = static_cast<int>(degree.size());
+    stats.num_pins = num_pins;
+    stats.max_net_degree = degree.empty() ? 0 : *std::max_element(degree.begin(), degree.end());
+    return stats;
+}
+
+std::string node_name(int node) {
+    return "o" + std::to_string(node);
+}
+}
+
+Hypergraph generate_hypergraph(const GeneratorOptions& options, GeneratorStats* stats) {
+    NetlistGenerator generator(options);
+    if (!generator.error.empty()) {
+        std::cerr << "Error: " << generator.error << std::endl;
+        exit(1);
+    }
+    Hypergraph graph;
+    graph.node_names.reserve(options.num_nodes, 8ll * options.num_nodes);
+    for (int node = 0; node < options.num_nodes; node++) {
+        graph.add_node(node_name(node), generator.width[node], generator.height[node], node < generator.num_movable ? NodeTypeEnum::node : NodeTypeEnum::terminal);
+    }
+    std::vector<int> nodes;
+    std::vector<float> delta_width;
+    std::vector<float> delta_height;
+    for (int net = 0; net < options.num_nets; net++) {
+        generator.next_net(nodes, delta_width, delta_height);
+        graph.add_net("n" + std::to_string(net));
+        for (size_t pin = 0; pin < nodes.size(); pin++) {
+            graph.add_pin(nodes[pin], delta_width[pin], delta_height[pin]);
+        }
+    }
+    graph.finalize();
+    if (stats != nullptr) {
+        *stats = generator.stats();
+    }
+    return graph;
+}
+
+bool generate_bookshelf(const std::string& aux_file_dir, const GeneratorOptions& options, GeneratorStats* stats) {
+    NetlistGenerator generator(options);
+    if (!generator.error.empty()) {
+        std::cerr << "Error: " << generator.error << std::endl;
+        return false;
+    }
+    std::string base = aux_file_dir.size() > 4 && aux_file_dir.compare(aux_file_dir.size() - 4, 4, ".aux") == 0 ? aux_file_dir.substr(0, aux_file_dir.size() - 4) : aux_file_dir;
+    std::string name = base.substr(base.find_last_of('/') == std::string::npos ? 0 : base.find_last_of('/') + 1);
+    TextWriter writer;
+    auto open = [&](const std::string& extension) {
+        if (!writer.open(base + extension)) {
+            std::cerr << "Error: cannot open file " << base + extension << std::endl;
+            return false;
+        }
+        return true;
+    };
+    auto close = [&](const std::string& extension) {
+        if (!writer.close()) {
+            std::cerr << "Error: cannot write file " << base + extension << std::endl;
+            return false;
+        }
+        return true;
+    };
+    GeneratorStats generated = generator.stats();
+
+    if (!open(".aux")) {
+        return false;
+    }
+    writer << "RowBasedPlacement : " << name << ".nodes " << name << ".nets " << name << ".wts " << name << ".pl " << name << ".scl\n";
+    if (!close(".aux") || !open(".nodes")) {
+        return false;
+    }
+    writer << "UCLA nodes 1.0\n# Created by the libVLSI generator, seed " << options.seed << "\n\n";
+    writer << "NumNodes : " << generated.num_nodes << "\nNumTerminals : " << generated.num_terminals << "\n\n";
+    for (int node = 0; node < generated.num_nodes; node++) {
+        writer << "\to" << node << '\t' << static_cast<double>(generator.width[node]) << '\t' << static_cast<double>(generator.height[node]) << (node < generator.num_movable ? "\n" : "\tterminal\n");
+    }
+    if (!close(".nodes") || !open(".nets")) {
+        return false;
+    }
+    writer << "UCLA nets 1.0\n# Created by the libVLSI generator, seed " << options.seed << "\n\n";
+    writer << "NumNets : " << generated.num_nets << "\nNumPins : " << generated.num_pins << "\n\n";
+    std::vector<int> nodes;
+    std::vector<float> delta_width;
+    std::vector<float> delta_height;
+    for (int net = 0; net < generated.num_nets; net++) {
+        generator.next_net(nodes, delta_width, delta_height);
+        writer << "NetDegree : " << static_cast<int>(nodes.size()) << "\tn" << net << '\n';
+        for (size_t pin = 0; pin < nodes.size(); pin++) {
+            writer << "\to" << nodes[pin] << (pin == 0 ? " O : " : " I : ") << static_cast<double>(delta_width[pin]) << ' ' << static_cast<double>(delta_height[pin]) << '\n';
+        }
+    }
+    if (!close(".nets") || !open(".wts")) {
+        return false;
+    }
+    writer << "UCLA wts 1.0\n";
+
+    // ## rows of a square core with the requested utilization
+    double core_area = std::max(generator.movable_area / options.utilization, options.row_height * options.row_height);
+    int num_rows = std::max(1, static_cast<int>(std::ceil(std::sqrt(core_area) / options.row_height)));
+    int num_sites = std::max(1, static_cast<int>(std::ceil(core_area / (num_rows * options.row_height))));
+    if (!close(".wts") || !open(".scl")) {
+        return false;
+    }
+    writer << "UCLA scl 1.0\n\nNumRows : " << num_rows << "\n\n";
+    for (int row = 0; row < num_rows; row++) {
+        writer << "CoreRow Horizontal\n  Coordinate : " << row * options.row_height << "\n  Height : " << options.row_height << "\n  Sitewidth : 1\n  Sitespacing : 1\n  Siteorient : N\n  Sitesymmetry : Y\n  SubrowOrigin : 0\tNumSites : " << num_sites << "\nEnd\n";
+    }
+
+    // ## movable nodes at random on the rows, terminals evenly spaced on the core boundary
+    if (!close(".scl") || !open(".pl")) {
+        return false;
+    }
+    writer << "UCLA pl 1.0\n# Created by the libVLSI generator, seed " << options.seed << "\n\n";
+    std::mt19937_64 place_rng(options.seed ^ 0x706C6163ull);
+    double core_width = num_sites;
+    double core_height = num_rows * options.row_height;
+    double perimeter = 2 * (core_width + core_height);
+    for (int node = 0; node < generated.num_nodes; node++) {
+        double x;
+        double y;
+        if (node < generator.num_movable) {
+            x = std::floor(std::max(0.0, core_width - generator.width[node]) * std::uniform_real_distribution<double>(0, 1)(place_rng));
+            y = static_cast<double>(place_rng() % num_rows) * options.row_height;
+            writer << "o" << node << '\t' << x << '\t' << y << "\t: N\n";
+            continue;
+        }
+        double t = perimeter * (node - generator.num_movable) / generated.num_terminals;
+        if (t < core_width) {
+            x = t;
+            y = 0;
+        }
+        else if (t < core_width + core_height) {
+            x = core_width;
+            y = t - core_width;
+        }
+        else if (t < 2 * core_width + core_height) {
+            x = 2 * core_width + core_height - t;
+            y = core_height;
+        }
+        else {
+            x = 0;
+            y = perimeter - t;
+        }
+        writer << "o" << node << '\t' << std::floor(x) << '\t' << std::floor(y) << "\t: N /FIXED\n";
+    }
+    if (!close(".pl")) {
+        return false;
+    }
+    if (stats != nullptr) {
+        *stats = generated;
+    }
+    return true;
+}
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+#include "../include/hmetis.h"
+#include "../include/text_io.h"
+#include "../include/thread_pool.h"
+
+namespace {
+
+// smallest chunk of an .hgr file worth a thread of its own
+const size_t min_chunk_bytes = 1 << 20;
+
+// integers of the lines of one chunk of an .hgr body, comments and blank lines are skipped
+struct LineChunk {
+public:
+    const char* begin;
+    const char* end;
+    std::vector<int> line_sizes; // number of integers on each line
+    std::vector<int> values; // integers of all the lines, back to back
+    const char* error_position; // nullptr if the chunk was parsed
+    LineChunk() : begin(nullptr), end(nullptr), error_position(nullptr) {}
+};
+
+void parse_line_chunk(LineChunk& chunk) {
+    const char* cur = chunk.begin;
+    const char* end = chunk.end;
+    while (cur < end) {
+        while (cur < end && TextScanner::is_blank(*cur)) {
+            cur++;
+        }
+        if (cur < end && *cur == '%') {
+            while (cur < end && *cur != '\n') {
+                cur++;
+            }
+        }
+        if (cur < end && *cur == '\n') {
+            cur++;
+            continue;
+        }
+        int line_size = 0;
+        while (cur < end && *cur != '\n') {
+            int value;
+            auto result = std::from_chars(cur, end, value);
+            // a number ends at a blank or at the end of the line
+            if (result.ec != std::errc() || (result.ptr < end && !TextScanner::is_space(*result.ptr))) {
+                chunk.error_position = cur;
+                return;
+            }
+            chunk.values.push_back(value);
+            line_size++;
+            cur = result.ptr;
+            while (cur < end && TextScanner::is_blank(*cur)) {
+                cur++;
+            }
+        }
+        if (line_size > 0) {
+            chunk.line_sizes.push_back(line_size);
+        }
+    }
+}
+
+// start of the line after position
+const char* next_line_start(const char* position, const char* end) {
+    position = std::find(position, end, '\n');
+    return position < end ? position + 1 : end;
+}
+
+// 1-based id of node or net i as a name
+std::string_view id_name(int i, char (&digits)[16]) {
+    char* last = std::to_chars(digits, digits + sizeof(digits), i + 1).ptr;
+    return std::string_view(digits, static_cast<size_t>(last - digits));
+}
+
+}
+
+bool is_hmetis_file(const std::string& file_dir) {
+    return file_dir.size() > 4 && file_dir.compare(file_dir.size() - 4, 4, ".hgr") == 0;
+}
+
+bool load_hmetis(const std::string& hgr_file_dir, Hypergraph& graph, std::string& error, std::vector<int>* net_weights, int num_threads) {
+    MappedFile hgr_file;
+    if (!hgr_file.open(hgr_file_dir)) {
+        error = "cannot open file " + hgr_file_dir;
+        return false;
+    }
+    TextScanner scanner(hgr_file.begin(), hgr_file.end());
+    // header line "<num nets> <num vertices> [fmt]" after the leading comments
+    while (!scanner.at_end() && *scanner.cur == '%') {
+        scanner.skip_line();
+    }
+    int num_nets;
+    int num_nodes;
+    int fmt = 0;
+    if (!scanner.parse_int(num_nets) || !scanner.parse_int(num_nodes) || num_nets < 0 || num_nodes < 0 || (!scanner.at_line_end() && !scanner.parse_int(fmt))) {
+        error = "expected <num nets> <num vertices> [fmt] at line " + std::to_string(line_number_of(hgr_file.begin(), scanner.cur)) + " of file " + hgr_file_dir;
+        return false;
+    }
+    if (fmt != 0 && fmt != 1 && fmt != 10 && fmt != 11) {
+        error = "unknown fmt " + std::to_string(fmt) + " in file " + hgr_file_dir;
+        return false;
+    }
+    bool has_net_weights = fmt % 10 == 1;
+    bool has_node_weights = fmt / 10 == 1;
+    scanner.skip_line();
+    const char* body = scanner.cur;
+
+    // split the body at line starts, one chunk per thread
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    size_t body_size = static_cast<size_t>(hgr_file.end() - body);
+    int num_chunks = static_cast<int>(std::max<size_t>(1, std::min<size_t>(std::max(num_threads, 1), body_size / min_chunk_bytes)));
+    std::vector<LineChunk> chunks(num_chunks);
+    const char* chunk_begin = body;
+    for (int c = 0; c < num_chunks; c++) {
+        const char* chunk_end = c + 1 == num_chunks ? hgr_file.end() : next_line_start(std::max(chunk_begin, body + body_size * (c + 1) / num_chunks), hgr_file.end());
+        chunks[c].begin = chunk_begin;
+        chunks[c].end = chunk_end;
+        chunk_begin = chunk_end;
+    }
+    std::vector<std::thread> threads;
+    for (int c = 1; c < num_chunks; c++) {
+        threads.emplace_back(parse_line_chunk, std::ref(chunks[c]));
+    }
+    parse_line_chunk(chunks[0]);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    size_t num_lines = 0;
+    size_t num_values = 0;
+    for (const LineChunk& chunk : chunks) {
+        if (chunk.error_position != nullptr) {
+            error = "expected an integer at line " + std::to_string(line_number_of(hgr_file.begin(), chunk.error_position)) + " of file " + hgr_file_dir;
+            return false;
+        }
+        num_lines += chunk.line_sizes.size();
+        num_values += chunk.values.size();
+    }
+    size_t expected_lines = static_cast<size_t>(num_nets) + (has_node_weights ? num_nodes : 0);
+    if (num_lines != expected_lines) {
+        error = "expected " + std::to_string(expected_lines) + " net and vertex weight lines but found " + std::to_string(num_lines) + " in file " + hgr_file_dir;
+        return false;
+    }
+
+    // merge the chunks in order: the net lines first, then the vertex weight lines
+    graph.clear();
+    graph.net_pin_offsets.reserve(static_cast<size_t>(num_nets) + 1);
+    graph.pin_node.reserve(num_values);
+    graph.pin_delta_width.reserve(num_values);
+    graph.pin_delta_height.reserve(num_values);
+    if (net_weights != nullptr) {
+        net_weights->assign(num_nets, 1);
+    }
+    std::vector<int> node_weight(num_nodes, 1);
+    char digits[16];
+    int line = 0;
+    for (const LineChunk& chunk : chunks) {
+        const int* values = chunk.values.data();
+        for (int line_size : chunk.line_sizes) {
+            if (line < num_nets) {
+                int net = line;
+                int first = has_net_weights ? 1 : 0;
+                if (line_size <= first || (has_net_weights && values[0] < 0)) {
+                    error = "net " + std::to_string(net + 1) + " has no vertices or a negative weight in file " + hgr_file_dir;
+                    return false;
+                }
+                if (net_weights != nullptr && has_net_weights) {
+                    (*net_weights)[net] = values[0];
+                }
+                graph.add_net(id_name(net, digits));
+                for (int i = first; i < line_size; i++) {
+                    if (values[i] < 1 || values[i] > num_nodes) {
+                        error = "net " + std::to_string(net + 1) + " has vertex " + std::to_string(values[i]) + ", out of 1.." + std::to_string(num_nodes) + " in file " + hgr_file_dir;
+                        return false;
+                    }
+                    graph.add_pin(values[i] - 1, 0, 0);
+                }
+            }
+            else {
+                int node = line - num_nets;
+                if (line_size != 1 || values[0] < 0) {
+                    error = "vertex " + std::to_string(node + 1) + " needs one non negative weight in file " + hgr_file_dir;
+                    return false;
+                }
+                node_weight[node] = values[0];
+            }
+            values += line_size;
+            line++;
+        }
+    }
+    graph.node_names.reserve(num_nodes, static_cast<size_t>(num_nodes) * 7);
+    for (int node = 0; node < num_nodes; node++) {
+        graph.add_node(id_name(node, digits), node_weight[node], 1);
+    }
+    graph.finalize();
+    return true;
+}
+
+bool write_hmetis(const std::string& hgr_file_dir, const Hypergraph& graph, std::string& error, const std::vector<int>* net_weights, int num_threads) {
+    TextWriter writer;
+    if (!writer.open(hgr_file_dir)) {
+        error = "cannot open file " + hgr_file_dir;
+        return false;
+    }
+    std::unique_ptr<ThreadPool> pool;
+    if (num_threads != 1) {
+        pool = std::make_unique<ThreadPool>(num_threads);
+    }
+    auto node_weight = [&](int node) { return std::max(1ll, std::llround(graph.node_size[node])); };
+    bool has_node_weights = false;
+    for (int node = 0; node < graph.num_nodes() && !has_node_weights; node++) {
+        has_node_weights = graph.node_size[node] != 1;
+    }
+    bool has_net_weights = net_weights != nullptr;
+    writer << graph.num_nets() << ' ' << graph.num_nodes();
+    if (has_net_weights || has_node_weights) {
+        writer << ' ' << (has_node_weights ? 10 : 0) + (has_net_weights ? 1 : 0);
+    }
+    writer << '\n';
+    write_parallel(writer, graph.num_nets(), 16384, pool.get(), [&](TextBuffer& buffer, int begin, int end) {
+        for (int net = begin; net < end; net++) {
+            if (has_net_weights) {
+                buffer << (*net_weights)[net] << ' ';
+            }
+            bool first = true;
+            for (int node : graph.nodes_of(net)) {
+                buffer << (first ? "" : " ") << node + 1;
+                first = false;
+            }
+            buffer << '\n';
+        }
+    });
+    if (has_node_weights) {
+        write_parallel(writer, graph.num_nodes(), 16384, pool.get(), [&](TextBuffer& buffer, int begin, int end) {
+            for (int node = begin; node < end; node++) {
+                buffer << node_weight(node) << '\n';
+            }
+        });
+    }
+    if (!writer.close()) {
+        error = "cannot write file " + hgr_file_dir;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,221 @@
+#include "../include/hypergraph.h"
+
+NameTable::NameTable() : indexed(true) {
+    offsets = std::vector<int64_t>(1, 0);
+    slots = std::vector<uint64_t>(16, 0);
+}
+
+uint64_t NameTable::_hash(std::string_view name) {
+    // FNV-1a
+    uint64_t hash = 1469598103934665603ULL;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void NameTable::_index(int id) {
+    size_t mask = slots.size() - 1;
+    uint64_t hash = _hash((*this)[id]);
+    size_t slot = hash & mask;
+    while (slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    slots[slot] = (hash & 0xffffffff00000000ULL) | static_cast<uint64_t>(id + 1);
+}
+
+void NameTable::_rehash(size_t num_slots) {
+    // keep the load factor below one half
+    size_t capacity = 16;
+    while (capacity < 2 * num_slots) {
+        capacity <<= 1;
+    }
+    slots.assign(capacity, 0);
+    for (int id = 0; id < size(); id++) {
+        _index(id);
+    }
+    indexed = true;
+}
+
+int NameTable::add(std::string_view name) {
+    pool.insert(pool.end(), name.begin(), name.end());
+    offsets.push_back(static_cast<int64_t>(pool.size()));
+    int id = size() - 1;
+    if (indexed) {
+        if (2 * static_cast<size_t>(size()) > slots.size()) {
+            _rehash(static_cast<size_t>(size()));
+        }
+        else {
+            _index(id);
+        }
+    }
+    return id;
+}
+
+int NameTable::intern(std::string_view name) {
+    int id = find(name);
+    return id >= 0 ? id : add(name);
+}
+
+int NameTable::find(std::string_view name) const {
+    if (!indexed) {
+        // lazily build the index on first lookup
+        const_cast<NameTable*>(this)->build_index();
+    }
+    size_t mask = slots.size() - 1;
+    uint64_t hash = _hash(name);
+    size_t slot = hash & mask;
+    while (slots[slot] != 0) {
+        // compare the stored upper hash bits before touching the name itself
+        int id = static_cast<int>(slots[slot] & 0xffffffffULL) - 1;
+        if ((slots[slot] >> 32) == (hash >> 32) && (*this)[id] == name) {
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+void NameTable::build_index() {
+    if (!indexed) {
+        _rehash(static_cast<size_t>(size()));
+    }
+}
+
+void NameTable::drop_index() {
+    indexed = false;
+    slots.assign(16, 0);
+}
+
+void NameTable::reserve(size_t num_names, size_t num_chars) {
+    pool.reserve(num_chars);
+    offsets.reserve(num_names + 1);
+    if (indexed && 2 * num_names > slots.size()) {
+        _rehash(num_names);
+    }
+}
+
+void NameTable::clear() {
+    pool.clear();
+    offsets.assign(1, 0);
+    slots.assign(16, 0);
+    indexed = true;
+}
+
+void NameTable::assign(const char* characters, const int64_t* name_offsets, int num_names) {
+    pool.assign(characters, characters + name_offsets[num_names]);
+    offsets.assign(name_offsets, name_offsets + num_names + 1);
+    drop_index();
+}
+
+size_t NameTable::memory_bytes() const {
+    return pool.capacity() * sizeof(char) + offsets.capacity() * sizeof(int64_t) + slots.capacity() * sizeof(uint64_t);
+}
+
+Hypergraph::Hypergraph() {
+    net_pin_offsets = std::vector<int>(1, 0);
+    net_node_offsets = std::vector<int>(1, 0);
+    node_net_offsets = std::vector<int>(1, 0);
+}
+
+int Hypergraph::add_node(std::string_view name, double width, double height, NodeTypeEnum type) {
+    node_width.push_back(width);
+    node_height.push_back(height);
+    node_size.push_back(width * height);
+    node_type.push_back(type);
+    return node_names.add(name);
+}
+
+int Hypergraph::add_net(std::string_view name) {
+    net_pin_offsets.push_back(static_cast<int>(pin_node.size()));
+    return net_names.add(name);
+}
+
+void Hypergraph::add_pin(int node, float delta_width, float delta_height) {
+    pin_node.push_back(node);
+    pin_delta_width.push_back(delta_width);
+    pin_delta_height.push_back(delta_height);
+    net_pin_offsets.back() = static_cast<int>(pin_node.size());
+}
+
+void Hypergraph::finalize() {
+    int num_node = num_nodes();
+    int num_net = num_nets();
+    // distinct nodes of each net, in order of their first pin
+    // last_net[node] is the last net that already listed this node
+    std::vector<int> last_net(num_node, -1);
+    net_node_offsets.assign(1, 0);
+    net_node_offsets.reserve(num_net + 1);
+    net_nodes.clear();
+    net_nodes.reserve(pin_node.size());
+    std::vector<int> degree(num_node + 1, 0);
+    for (int net = 0; net < num_net; net++) {
+        for (int node : pins_of(net)) {
+            if (last_net[node] != net) {
+                last_net[node] = net;
+                net_nodes.push_back(node);
+                degree[node + 1]++;
+            }
+        }
+        net_node_offsets.push_back(static_cast<int>(net_nodes.size()));
+    }
+    net_nodes.shrink_to_fit();
+    // distinct nets of each node, counting sort keeps them in ascending net id
+    for (int node = 0; node < num_node; node++) {
+        degree[node + 1] += degree[node];
+    }
+    node_net_offsets = degree;
+    node_nets.assign(net_nodes.size(), 0);
+    for (int net = 0; net < num_net; net++) {
+        for (int node : nodes_of(net)) {
+            node_nets[degree[node]++] = net;
+        }
+    }
+}
+
+void Hypergraph::clear() {
+    *this = Hypergraph();
+}
+
+Hypergraph Hypergraph::extract(const std::vector<int>& part_of, int part, int min_net_nodes) const {
+    Hypergraph sub;
+    // old node id -> new node id, -1 if the node is not in this part
+    std::vector<int> new_id(num_nodes(), -1);
+    for (int node = 0; node < num_nodes(); node++) {
+        if (part_of[node] == part) {
+            new_id[node] = sub.add_node(node_names[node], node_width[node], node_height[node], node_type[node]);
+        }
+    }
+    for (int net = 0; net < num_nets(); net++) {
+        if (min_net_nodes > 1) {
+            int net_nodes_in_part = 0;
+            for (int node : nodes_of(net)) {
+                net_nodes_in_part += new_id[node] >= 0;
+            }
+            if (net_nodes_in_part < min_net_nodes) {
+                continue;
+            }
+        }
+        bool has_pin = false;
+        for (int pin = net_pin_offsets[net]; pin < net_pin_offsets[net + 1]; pin++) {
+            if (new_id[pin_node[pin]] < 0) {
+                continue;
+            }
+            if (!has_pin) {
+                sub.add_net(net_names[net]);
+                has_pin = true;
+            }
+            sub.add_pin(new_id[pin_node[pin]], pin_delta_width[pin], pin_delta_height[pin]);
+        }
+    }
+    sub.finalize();
+    return sub;
+}
+
+size_t Hypergraph::memory_bytes() const {
+    return node_width.capacity() * sizeof(double) * 3 + node_type.capacity() * sizeof(NodeTypeEnum) + node_names.memory_bytes()
+        + (net_pin_offsets.capacity() + pin_node.capacity()) * sizeof(int)
+        + (pin_delta_width.capacity() + pin_delta_height.capacity()) * sizeof(float) + net_names.memory_bytes()
+        + (net_node_offsets.capacity() + net_nodes.capacity() + node_net_offsets.capacity() + node_nets.capacity()) * sizeof(int);
+}
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+
+#include "../include/kway.h"
+#include "../include/kway_fm.h"
+#include "../include/thread_pool.h"
+
+KWayOptions::KWayOptions() : num_parts(2), imbalance(0.05), multilevel(true), refine(true), num_threads(0), seed(13) {}
+
+void evaluate_kway(const Hypergraph& graph, int area_constraint, KWayResult& result) {
+    result.part_weight = std::vector<double>(result.num_parts, 0);
+    double total_weight = 0;
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        double weight = area_constraint == 0 ? 1.0 : graph.node_size[node];
+        result.part_weight[result.part[node]] += weight;
+        total_weight += weight;
+    }
+    // last_net[p] is the last net that already has a node in part p
+    std::vector<int> last_net(result.num_parts, -1);
+    result.cut = 0;
+    result.connectivity = 0;
+    for (int net = 0; net < graph.num_nets(); net++) {
+        int net_parts = 0;
+        for (int node : graph.nodes_of(net)) {
+            int p = result.part[node];
+            if (last_net[p] != net) {
+                last_net[p] = net;
+                net_parts++;
+            }
+        }
+        if (net_parts > 1) {
+            result.cut++;
+            result.connectivity += net_parts - 1;
+        }
+    }
+    double max_part_weight = *std::max_element(result.part_weight.begin(), result.part_weight.end());
+    result.imbalance = total_weight > 0 ? max_part_weight * result.num_parts / total_weight - 1 : 0;
+}
+
+namespace {
+// ## a part of the hypergraph to split into num_parts parts, numbered from first_part
+struct Subproblem {
+public:
+    std::shared_ptr<const Hypergraph> graph;
+    std::vector<int> original_node; // node id in graph -> node id in the input hypergraph
+    int first_part;
+    int num_parts;
+};
+
+// the seed of a bisection only depends on its place in the bisection tree
+unsigned subproblem_seed(unsigned seed, int first_part, int num_parts) {
+    uint64_t x = seed + 0x9E3779B97F4A7C15ull * (static_cast<uint64_t>(first_part) << 32 | static_cast<uint32_t>(num_parts));
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<unsigned>(x ^ (x >> 31));
+}
+
+class RecursiveBisection {
+private:
+    const KWayOptions& options;
+    ThreadPool& pool;
+    TaskGroup& group;
+    double total_weight;
+    std::vector<int>& part; // written by every task, each node exactly once
+public:
+    RecursiveBisection(const KWayOptions& options, ThreadPool& pool, TaskGroup& group, double total_weight, std::vector<int>& part)
+        : options(options), pool(pool), group(group), total_weight(total_weight), part(part) {}
+
+    void bisect(const Subproblem& sub);
+};
+
+void RecursiveBisection::bisect(const Subproblem& sub) {
+    const Hypergraph& graph = *sub.graph;
+    if (sub.num_parts == 1 || graph.num_nodes() == 0) {
+        for (int node = 0; node < graph.num_nodes(); node++) {
+            part[sub.original_node[node]] = sub.first_part;
+        }
+        return;
+    }
+    const FMOptions& fm = options.bisection.fm;
+    ScopedPhase phase(fm.metrics, "kway_bisection");
+    double sub_weight = 0;
+    double max_node_weight = 0;
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        double weight = fm.area_constraint == 0 ? 1.0 : graph.node_size[node];
+        sub_weight += weight;
+        max_node_weight = std::max(max_node_weight, weight);
+    }
+    int parts[2] = {(sub.num_parts + 1) / 2, sub.num_parts / 2};
+    double fraction = static_cast<double>(parts[0]) / sub.num_parts;
+    // spread the allowed imbalance over the remaining levels, a subproblem lighter than its share may deviate more
+    int remaining_levels = static_cast<int>(std::ceil(std::log2(sub.num_parts)));
+    double level_imbalance = std::pow((1 + options.imbalance) * total_weight / options.num_parts * sub.num_parts / sub_weight, 1.0 / remaining_levels) - 1;
+    double tolerance = std::max(std::max(level_imbalance, 0.0) * sub_weight * std::min(parts[0], parts[1]) / sub.num_parts, max_node_weight);
+    unsigned seed = subproblem_seed(options.seed, sub.first_part, sub.num_parts);
+
+    std::vector<int> partition;
+    if (options.multilevel) {
+        MultilevelOptions bisection = options.bisection;
+        bisection.fm.max_imbalance = tolerance;
+        bisection.fm.target_fraction = fraction;
+        bisection.fm.dump_level = -1;
+        // the bisections already run in parallel, initialize each FM serially
+        bisection.fm.num_threads = 1;
+        bisection.fm.pool = nullptr;
+        // a workspace serves one FMBipartitioner at a time, every bisection makes its own
+        bisection.fm.workspace = nullptr;
+        // the subproblems have their own node ids, only the terminals can stay fixed
+        bisection.fm.fixed_part = nullptr;
+        bisection.seed = seed;
+        multilevel_bipartition(graph, bisection, partition);
+    }
+    else {
+        FMOptions bisection = fm;
+        bisection.max_imbalance = tolerance;
+        bisection.target_fraction = fraction;
+        bisection.dump_level = -1;
+        bisection.num_threads = 1;
+        bisection.pool = nullptr;
+        bisection.workspace = nullptr;
+        bisection.fixed_part = nullptr;
+        // random order, each node goes to the part that is lighter relative to its target
+        std::vector<int> order(graph.num_nodes());
+        std::iota(order.begin(), order.end(), 0);
+        std::mt19937 rng(seed);
+        std::shuffle(order.begin(), order.end(), rng);
+        partition = std::vector<int>(graph.num_nodes(), 0);
+        double part_weight[2] = {0, 0};
+        for (int node : order) {
+            int p = part_weight[0] * (1 - fraction) <= part_weight[1] * fraction ? 0 : 1;
+            partition[node] = p;
+            part_weight[p] += fm.area_constraint == 0 ? 1.0 : graph.node_size[node];
+        }
+        FMBipartitioner bipartitioner(graph, bisection);
+        bipartitioner.run(partition);
+    }
+
+    for (int side = 0; side < 2; side++) {
+        Subproblem half;
+        half.first_part = sub.first_part + (side == 0 ? 0 : parts[0]);
+        half.num_parts = parts[side];
+        if (half.num_parts == 1) {
+            for (int node = 0; node < graph.num_nodes(); node++) {
+                if (partition[node] == side) {
+                    part[sub.original_node[node]] = half.first_part;
+                }
+            }
+            continue;
+        }
+        // nets left with a single node can never be cut again, drop them
+        half.graph = std::make_shared<const Hypergraph>(graph.extract(partition, side, 2));
+        for (int node = 0; node < graph.num_nodes(); node++) {
+            if (partition[node] == side) {
+                half.original_node.push_back(sub.original_node[node]);
+            }
+        }
+        pool.submit(group, [this, half] { bisect(half); });
+    }
+}
+}
+
+KWayResult recursive_bisection(const Hypergraph& graph, const KWayOptions& options) {
+    auto start = std::chrono::high_resolution_clock::now();
+    if (options.num_parts < 1) {
+        std::cerr << "Error: the number of parts must be at least 1, got " << options.num_parts << std::endl;
+        exit(1);
+    }
+    KWayResult result;
+    result.num_parts = options.num_parts;
+    result.part = std::vector<int>(graph.num_nodes(), 0);
+    double total_weight = 0;
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        total_weight += options.bisection.fm.area_constraint == 0 ? 1.0 : graph.node_size[node];
+    }
+
+    ThreadPool pool(options.num_threads);
+    TaskGroup group;
+    RecursiveBisection bisection(options, pool, group, total_weight, result.part);
+    Subproblem root;
+    // the input hypergraph outlives the tasks, do not take ownership
+    root.graph = std::shared_ptr<const Hypergraph>(&graph, [](const Hypergraph*) {});
+    root.original_node.resize(graph.num_nodes());
+    std::iota(root.original_node.begin(), root.original_node.end(), 0);
+    root.first_part = 0;
+    root.num_parts = options.num_parts;
+    pool.submit(group, [&bisection, root] { bisection.bisect(root); });
+    pool.wait(group);
+    auto end = std::chrono::high_resolution_clock::now();
+    if (options.bisection.fm.dump_level == 0) {
+        std::cout << "Time to partition into " << options.num_parts << " parts by recursive bisection on " << pool.num_threads() << " threads: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+    }
+    if (options.bisection.fm.metrics != nullptr) {
+        options.bisection.fm.metrics->record_phase("kway_recursive_bisection", start, end);
+    }
+
+    if (options.refine && options.num_parts > 1) {
+        ScopedPhase phase(options.bisection.fm.metrics, "kway_refine");
+        KWayFMRefiner refiner(graph, options.num_parts, (1 + options.imbalance) * total_weight / options.num_parts, options.bisection.fm);
+        refiner.run(result.part);
+    }
+    evaluate_kway(graph, options.bisection.fm.area_constraint, result);
+    return result;
+}
@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "../include/kway_fm.h"
+
+KWayFMRefiner::KWayFMRefiner(const Hypergraph& graph, int num_parts, double max_part_weight, FMOptions options)
+    : graph(graph), options(options), num_parts(num_parts), max_part_weight(max_part_weight) {
+    int num_nodes = graph.num_nodes();
+    node_weight = options.area_constraint == 0 ? std::vector<double>(num_nodes, 1.0) : graph.node_size;
+    // pmax: a gain is at most the number of nets on the node
+    int max_degree = 0;
+    for (int node = 0; node < num_nodes; node++) {
+        max_degree = std::max(max_degree, graph.nets_of(node).size());
+    }
+    bucket.reset(max_degree, num_nodes);
+    part_weight = std::vector<double>(num_parts, 0);
+    pin_count = std::vector<int>(static_cast<size_t>(graph.num_nets()) * num_parts, 0);
+    net_parts = std::vector<int>(graph.num_nets(), 0);
+    cache_valid = std::vector<char>(num_nodes, false);
+    benefit = std::vector<int>(num_nodes, 0);
+    connection = std::vector<int>(static_cast<size_t>(num_nodes) * num_parts, 0);
+    target = std::vector<int>(num_nodes, -1);
+    node_fixed = std::vector<char>(num_nodes, false);
+    if (options.fix_terminals) {
+        for (int node = 0; node < num_nodes; node++) {
+            node_fixed[node] = graph.node_type[node] != NodeTypeEnum::node;
+        }
+    }
+    node_locked = std::vector<char>(num_nodes, false);
+    is_touched = std::vector<char>(num_nodes, false);
+    connectivity = 0;
+}
+
+void KWayFMRefiner::_initialize_counters() {
+    std::fill(part_weight.begin(), part_weight.end(), 0);
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        part_weight[part[node]] += node_weight[node];
+    }
+    std::fill(pin_count.begin(), pin_count.end(), 0);
+    connectivity = 0;
+    for (int net = 0; net < graph.num_nets(); net++) {
+        int* counter = &pin_count[static_cast<size_t>(net) * num_parts];
+        net_parts[net] = 0;
+        for (int node : graph.nodes_of(net)) {
+            if (counter[part[node]]++ == 0) {
+                net_parts[net]++;
+            }
+        }
+        if (net_parts[net] > 1) {
+            connectivity += net_parts[net] - 1;
+        }
+    }
+    std::fill(cache_valid.begin(), cache_valid.end(), false);
+}
+
+void KWayFMRefiner::_compute_cache(int node) {
+    int* node_connection = &connection[static_cast<size_t>(node) * num_parts];
+    std::fill(node_connection, node_connection + num_parts, 0);
+    benefit[node] = 0;
+    for (int net : graph.nets_of(node)) {
+        const int* counter = &pin_count[static_cast<size_t>(net) * num_parts];
+        for (int p = 0; p < num_parts; p++) {
+            if (counter[p] > 0) {
+                node_connection[p]++;
+            }
+        }
+        if (counter[part[node]] == 1) {
+            benefit[node]++;
+        }
+    }
+    cache_valid[node] = true;
+}
+
+int KWayFMRefiner::_best_target(int node, int& gain) const {
+    const int* node_connection = &connection[static_cast<size_t>(node) * num_parts];
+    int best = -1;
+    for (int p = 0; p < num_parts; p++) {
+        // only parts that share a net with the node, moving anywhere else never reduces the connectivity
+        if (p == part[node] || node_connection[p] == 0 || part_weight[p] + node_weight[node] > max_part_weight) {
+            continue;
+        }
+        // ties go to the lighter part
+        if (best == -1 || node_connection[p] > node_connection[best] || (node_connection[p] == node_connection[best] && part_weight[p] < part_weight[best])) {
+            best = p;
+        }
+    }
+    if (best >= 0) {
+        gain = benefit[node] + node_connection[best] - graph.nets_of(node).size();
+    }
+    return best;
+}
+
+void KWayFMRefiner::_refresh(int node) {
+    if (!cache_valid[node]) {
+        _compute_cache(node);
+    }
+    int gain = 0;
+    int best = _best_target(node, gain);
+    target[node] = best;
+    if (best < 0) {
+        if (bucket.contains(node)) {
+            bucket.erase(node);
+        }
+    }
+    else if (bucket.contains(node)) {
+        if (bucket.gain(node) != gain) {
+            bucket.update_gain(node, gain);
+        }
+    }
+    else {
+        bucket.insert(node, gain);
+    }
+}
+
+void KWayFMRefiner::_move(int node, int to_part, bool update_gains) {
+    int from_part = part[node];
+    part[node] = to_part;
+    part_weight[from_part] -= node_weight[node];
+    part_weight[to_part] += node_weight[node];
+    for (int net : graph.nets_of(node)) {
+        int* counter = &pin_count[static_cast<size_t>(net) * num_parts];
+        int from_count = counter[from_part]--;
+        int to_count = counter[to_part]++;
+        if (from_count == 1) {
+            net_parts[net]--;
+            connectivity--;
+        }
+        if (to_count == 0) {
+            net_parts[net]++;
+            connectivity++;
+        }
+        // only these counts change a cache: the net leaves or enters a part, or a part is left with, or loses, a single pin
+        if (from_count > 2 && to_count > 1) {
+            continue;
+        }
+        for (int other : graph.nodes_of(net)) {
+            if (cache_valid[other]) {
+                int* other_connection = &connection[static_cast<size_t>(other) * num_parts];
+                if (from_count == 1) {
+                    other_connection[from_part]--;
+                }
+                if (to_count == 0) {
+                    other_connection[to_part]++;
+                }
+                if (other == node) {
+                    benefit[other] += (to_count == 0) - (from_count == 1);
+                }
+                else if (from_count == 2 && part[other] == from_part) {
+                    benefit[other]++;
+                }
+                else if (to_count == 1 && part[other] == to_part) {
+                    benefit[other]--;
+                }
+            }
+            if (update_gains && !node_locked[other] && !is_touched[other]) {
+                is_touched[other] = true;
+                touched.push_back(other);
+            }
+        }
+    }
+    if (!update_gains) {
+        return;
+    }
+    for (int other : touched) {
+        is_touched[other] = false;
+        _refresh(other);
+    }
+    touched.clear();
+}
+
+FMPassStats KWayFMRefiner::_pass(int pass) {
+    auto start = std::chrono::high_resolution_clock::now();
+    // the k-way pass does not count the pin visits, they stay 0; cut_before and cut_after hold the connectivity
+    FMPassStats pass_stats{};
+    pass_stats.pass = pass;
+    pass_stats.cut_before = static_cast<int>(connectivity);
+
+    // the bucket starts with the free boundary nodes, the nodes on nets with pins in more than one part; the fixed nodes stay
+    // locked for the whole pass, so no move puts them in the bucket either
+    bucket.reset(bucket.max_gain_bound(), graph.num_nodes());
+    std::copy(node_fixed.begin(), node_fixed.end(), node_locked.begin());
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        if (node_locked[node]) {
+            continue;
+        }
+        for (int net : graph.nets_of(node)) {
+            if (net_parts[net] > 1) {
+                _refresh(node);
+                break;
+            }
+        }
+    }
+    auto end_gain_init = std::chrono::high_resolution_clock::now();
+    move_log.clear();
+    move_from.clear();
+    long long min_connectivity = connectivity;
+    int best_prefix = 0;
+    while (!bucket.is_empty()) {
+        int node = bucket.get_max_gain_node();
+        // the part weights may have changed since the node was refreshed
+        int gain = 0;
+        int to_part = _best_target(node, gain);
+        if (to_part < 0) {
+            bucket.erase(node);
+            continue;
+        }
+        if (gain != bucket.gain(node)) {
+            bucket.update_gain(node, gain);
+            continue;
+        }
+        bucket.erase(node);
+        node_locked[node] = true;
+        move_log.push_back(node);
+        move_from.push_back(part[node]);
+        _move(node, to_part, true);
+
+        // remember the best prefix of the move log
+        if (connectivity < min_connectivity) {
+            min_connectivity = connectivity;
+            best_prefix = static_cast<int>(move_log.size());
+        }
+    }
+
+    // roll back the moves after the best prefix, the caches stay exact
+    for (int i = static_cast<int>(move_log.size()) - 1; i >= best_prefix; i--) {
+        _move(move_log[i], move_from[i], false);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    pass_stats.moves = static_cast<int>(move_log.size());
+    pass_stats.best_prefix = best_prefix;
+    pass_stats.cut_after = static_cast<int>(connectivity);
+    pass_stats.gain_init_ms = std::chrono::duration<double, std::milli>(end_gain_init - start).count();
+    pass_stats.time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    return pass_stats;
+}
+
+long long KWayFMRefiner::run(std::vector<int>& partition) {
+    auto start = std::chrono::high_resolution_clock::now();
+    part = partition;
+    _initialize_counters();
+    auto end = std::chrono::high_resolution_clock::now();
+    if (options.dump_level == 0) {
+        std::cout << "Time to initialize in k-way FM algo: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+    }
+
+    auto start_main_loop = std::chrono::high_resolution_clock::now();
+    stats.clear();
+    for (int pass = 1; pass <= options.max_passes; pass++) {
+        FMPassStats pass_stats = _pass(pass);
+        stats.push_back(pass_stats);
+        if (options.metrics != nullptr) {
+            MetricsBlock block;
+            block.count(MetricCounter::moves, pass_stats.moves);
+            options.metrics->merge(block);
+            options.metrics->sample("connectivity", pass_stats.cut_after);
+        }
+        if (options.dump_level == 0) {
+            std::cout << "k-way FM pass " << pass << ": " << pass_stats.moves << " moves, best prefix " << pass_stats.best_prefix << ", connectivity " << pass_stats.cut_before << " -> " << pass_stats.cut_after << ", " << static_cast<long long>(pass_stats.time_ms) << " ms" << std::endl;
+        }
+        // stop on no improvement, or on an improvement below the threshold
+        int improvement = pass_stats.cut_before - pass_stats.cut_after;
+        if (improvement <= 0 || improvement < options.min_relative_improvement * pass_stats.cut_before) {
+            break;
+        }
+    }
+    auto end_main_loop = std::chrono::high_resolution_clock::now();
+    if (options.dump_level == 0) {
+        std::cout << "Time to run main loop in k-way FM algo: " << std::chrono::duration_cast<std::chrono::milliseconds>(end_main_loop - start_main_loop).count() << " ms" << std::endl;
+    }
+
+    partition = part;
+    return connectivity;
+}
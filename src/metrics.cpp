@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "../include/metrics.h"
+
+const char* metric_name(MetricCounter counter) {
+    switch (counter) {
+        case MetricCounter::moves: return "moves";
+        case MetricCounter::gain_updates: return "gain_updates";
+        case MetricCounter::bucket_reinserts: return "bucket_reinserts";
+        case MetricCounter::max_gain_rescans: return "max_gain_rescans";
+        case MetricCounter::nets_touched: return "nets_touched";
+        default: return "unknown";
+    }
+}
+
+const char* metric_name(MetricHistogram histogram) {
+    switch (histogram) {
+        case MetricHistogram::move_gain: return "move_gain";
+        case MetricHistogram::net_degree_touched: return "net_degree_touched";
+        default: return "unknown";
+    }
+}
+
+Log2Histogram::Log2Histogram() : count(0), sum(0), min(LLONG_MAX), max(LLONG_MIN) {
+    bins.fill(0);
+}
+
+void Log2Histogram::merge(const Log2Histogram& other) {
+    for (int bin = 0; bin < num_bins; bin++) {
+        bins[bin] += other.bins[bin];
+    }
+    count += other.count;
+    sum += other.sum;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+namespace {
+// magnitudes 2^log2 .. 2^(log2 + 1) - 1 of a non zero bin
+void bin_magnitudes(int bin, unsigned long long& low, unsigned long long& high) {
+    int log2 = bin > Log2Histogram::num_bins / 2 ? bin - Log2Histogram::num_bins / 2 - 1 : Log2Histogram::num_bins / 2 - 1 - bin;
+    low = 1ull << log2;
+    high = low + (low - 1);
+}
+
+// clamped to the long long range
+long long signed_magnitude(unsigned long long magnitude, bool negative) {
+    if (negative) {
+        return magnitude > static_cast<unsigned long long>(LLONG_MAX) ? LLONG_MIN : -static_cast<long long>(magnitude);
+    }
+    return magnitude > static_cast<unsigned long long>(LLONG_MAX) ? LLONG_MAX : static_cast<long long>(magnitude);
+}
+}
+
+long long Log2Histogram::bin_low(int bin) {
+    if (bin == num_bins / 2) {
+        return 0;
+    }
+    unsigned long long low;
+    unsigned long long high;
+    bin_magnitudes(bin, low, high);
+    return bin > num_bins / 2 ? signed_magnitude(low, false) : signed_magnitude(high, true);
+}
+
+long long Log2Histogram::bin_high(int bin) {
+    if (bin == num_bins / 2) {
+        return 0;
+    }
+    unsigned long long low;
+    unsigned long long high;
+    bin_magnitudes(bin, low, high);
+    return bin > num_bins / 2 ? signed_magnitude(high, false) : signed_magnitude(low, true);
+}
+
+MetricsBlock::MetricsBlock() {
+    clear();
+}
+
+void MetricsBlock::clear() {
+    counters.fill(0);
+    histograms.fill(Log2Histogram());
+}
+
+Metrics::Metrics() : origin(std::chrono::high_resolution_clock::now()) {}
+
+long long Metrics::_us_since_origin(std::chrono::high_resolution_clock::time_point time) const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - origin).count();
+}
+
+int Metrics::_thread_id() {
+    auto inserted = thread_ids.emplace(std::this_thread::get_id(), static_cast<int>(thread_ids.size()));
+    return inserted.first->second;
+}
+
+void Metrics::merge(const MetricsBlock& block) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t counter = 0; counter < block.counters.size(); counter++) {
+        totals.counters[counter] += block.counters[counter];
+    }
+    for (size_t histogram = 0; histogram < block.histograms.size(); histogram++) {
+        totals.histograms[histogram].merge(block.histograms[histogram]);
+    }
+}
+
+void Metrics::record_phase(const std::string& name, std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end) {
+    TraceEvent event;
+    event.name = name;
+    event.start_us = _us_since_origin(start);
+    event.duration_us = std::max(0ll, _us_since_origin(end) - event.start_us);
+    event.value = 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    event.thread = _thread_id();
+    events.push_back(std::move(event));
+}
+
+void Metrics::sample(const std::string& name, double value) {
+    TraceEvent event;
+    event.name = name;
+    event.start_us = _us_since_origin(std::chrono::high_resolution_clock::now());
+    event.duration_us = -1;
+    event.value = value;
+    std::lock_guard<std::mutex> lock(mutex);
+    event.thread = _thread_id();
+    events.push_back(std::move(event));
+}
+
+long long Metrics::counter(MetricCounter counter) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals.counters[static_cast<int>(counter)];
+}
+
+Log2Histogram Metrics::histogram(MetricHistogram histogram) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals.histograms[static_cast<int>(histogram)];
+}
+
+std::vector<TraceEvent> Metrics::trace() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return events;
+}
+
+std::string Metrics::to_json() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    // phases in order of first appearance
+    std::vector<std::string> names;
+    std::map<std::string, long long> phase_count;
+    std::map<std::string, long long> phase_total_us;
+    std::map<std::string, long long> phase_max_us;
+    for (const TraceEvent& event : events) {
+        if (event.duration_us < 0) {
+            continue;
+        }
+        if (phase_count[event.name]++ == 0) {
+            names.push_back(event.name);
+        }
+        phase_total_us[event.name] += event.duration_us;
+        phase_max_us[event.name] = std::max(phase_max_us[event.name], event.duration_us);
+    }
+    std::ostringstream json;
+    json << "{\n  \"phases\": {";
+    for (size_t i = 0; i < names.size(); i++) {
+        json << (i == 0 ? "\n" : ",\n") << "    \"" << names[i] << "\": {\"count\": " << phase_count[names[i]] << ", \"total_ms\": " << phase_total_us[names[i]] / 1000.0 << ", \"max_ms\": " << phase_max_us[names[i]] / 1000.0 << "}";
+    }
+    json << (names.empty() ? "},\n" : "\n  },\n") << "  \"counters\": {\n";
+    for (int counter = 0; counter < static_cast<int>(MetricCounter::num_counters); counter++) {
+        json << "    \"" << metric_name(static_cast<MetricCounter>(counter)) << "\": " << totals.counters[counter] << (counter + 1 < static_cast<int>(MetricCounter::num_counters) ? ",\n" : "\n");
+    }
+    json << "  },\n  \"histograms\": {\n";
+    for (int h = 0; h < static_cast<int>(MetricHistogram::num_histograms); h++) {
+        const Log2Histogram& histogram = totals.histograms[h];
+        json << "    \"" << metric_name(static_cast<MetricHistogram>(h)) << "\": {\"count\": " << histogram.count << ", \"sum\": " << histogram.sum;
+        if (histogram.count > 0) {
+            json << ", \"min\": " << histogram.min << ", \"max\": " << histogram.max;
+        }
+        json << ", \"bins\": [";
+        bool first = true;
+        for (int bin = 0; bin < Log2Histogram::num_bins; bin++) {
+            if (histogram.bins[bin] == 0) {
+                continue;
+            }
+            json << (first ? "" : ", ") << "{\"low\": " << Log2Histogram::bin_low(bin) << ", \"high\": " << Log2Histogram::bin_high(bin) << ", \"count\": " << histogram.bins[bin] << "}";
+            first = false;
+        }
+        json << "]}" << (h + 1 < static_cast<int>(MetricHistogram::num_histograms) ? ",\n" : "\n");
+    }
+    json << "  }\n}\n";
+    return json.str();
+}
+
+std::string Metrics::to_chrome_trace() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream json;
+    json << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (size_t i = 0; i < events.size(); i++) {
+        const TraceEvent& event = events[i];
+        if (event.duration_us >= 0) {
+            json << "{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"ts\": " << event.start_us << ", \"dur\": " << event.duration_us << ", \"pid\": 1, \"tid\": " << event.thread << "}";
+        }
+        else {
+            json << "{\"name\": \"" << event.name << "\", \"ph\": \"C\", \"ts\": " << event.start_us << ", \"pid\": 1, \"tid\": " << event.thread << ", \"args\": {\"value\": " << event.value << "}}";
+        }
+        json << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    json << "]}\n";
+    return json.str();
+}
+
+namespace {
+bool write_text_file(const std::string& file_dir, const std::string& text) {
+    std::ofstream file(file_dir);
+    file << text;
+    if (!file) {
+        std::cerr << "Error: cannot write file " << file_dir << std::endl;
+        return false;
+    }
+    return true;
+}
+}
+
+bool Metrics::write_json(const std::string& file_dir) const {
+    return write_text_file(file_dir, to_json());
+}
+
+bool Metrics::write_chrome_trace(const std::string& file_dir) const {
+    return write_text_file(file_dir, to_chrome_trace());
+}
@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+
+#include "../include/multilevel.h"
+
+MultilevelOptions::MultilevelOptions() : coarsening(CoarseningScheme::first_choice), coarsest_nodes(200), max_levels(40), min_reduction(0.05), max_rated_net_size(50), initial_tries(8), seed(13) {}
+
+std::vector<int> cluster_nodes(const Hypergraph& graph, const std::vector<double>& node_weight, double max_cluster_weight, const MultilevelOptions& options, unsigned seed, int& num_clusters, const std::vector<int>* fixed_part) {
+    int num_nodes = graph.num_nodes();
+    // leader of the cluster of each node, -1 while the node is not clustered
+    std::vector<int> leader(num_nodes, -1);
+    // weight of the cluster led by a node
+    std::vector<double> cluster_weight = node_weight;
+    // rating of each candidate leader, only the touched entries are non zero
+    std::vector<double> rating(num_nodes, 0);
+    std::vector<int> touched;
+
+    // visit the nodes in random order
+    std::vector<int> order(num_nodes);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 rng(seed);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    auto is_fixed = [&](int node) { return fixed_part != nullptr && (*fixed_part)[node] >= 0; };
+
+    for (int node : order) {
+        if (leader[node] != -1 || is_fixed(node)) {
+            continue;
+        }
+        for (int net : graph.nets_of(node)) {
+            int net_size = graph.nodes_of(net).size();
+            if (net_size < 2 || net_size > options.max_rated_net_size) {
+                continue;
+            }
+            double net_rating = 1.0 / (net_size - 1);
+            for (int other : graph.nodes_of(net)) {
+                if (other == node || is_fixed(other)) {
+                    continue;
+                }
+                int target;
+                if (leader[other] == -1) {
+                    target = other;
+                }
+                else if (options.coarsening == CoarseningScheme::first_choice) {
+                    target = leader[other];
+                }
+                else {
+                    continue;
+                }
+                if (rating[target] == 0) {
+                    touched.push_back(target);
+                }
+                rating[target] += net_rating;
+            }
+        }
+        // best rated target that keeps the cluster light enough, ties go to the lighter cluster
+        int best = -1;
+        for (int target : touched) {
+            if (node_weight[node] + cluster_weight[target] <= max_cluster_weight
+                && (best == -1 || rating[target] > rating[best] || (rating[target] == rating[best] && cluster_weight[target] < cluster_weight[best]))) {
+                best = target;
+            }
+        }
+        for (int target : touched) {
+            rating[target] = 0;
+        }
+        touched.clear();
+        if (best == -1) {
+            // leave the node unclustered, a later node may still pick it
+            continue;
+        }
+        leader[best] = best;
+        leader[node] = best;
+        cluster_weight[best] += node_weight[node];
+    }
+
+    // number the clusters in order of their first node, unclustered nodes become singletons
+    std::vector<int> cluster_of_leader(num_nodes, -1);
+    std::vector<int> cluster(num_nodes);
+    num_clusters = 0;
+    for (int node = 0; node < num_nodes; node++) {
+        int node_leader = leader[node] == -1 ? node : leader[node];
+        if (cluster_of_leader[node_leader] == -1) {
+            cluster_of_leader[node_leader] = num_clusters++;
+        }
+        cluster[node] = cluster_of_leader[node_leader];
+    }
+    return cluster;
+}
+
+Hypergraph contract_hypergraph(const Hypergraph& graph, const std::vector<double>& node_weight, const std::vector<int>& cluster, int num_clusters) {
+    Hypergraph coarse;
+    // coarse nodes and nets have no names, do not index the empty names
+    coarse.node_names.drop_index();
+    coarse.net_names.drop_index();
+    std::vector<double> weight(num_clusters, 0);
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        weight[cluster[node]] += node_weight[node];
+    }
+    for (int c = 0; c < num_clusters; c++) {
+        coarse.add_node("", weight[c], 1);
+    }
+    // last_net[c] is the last net that already has a pin on cluster c
+    std::vector<int> last_net(num_clusters, -1);
+    std::vector<int> net_clusters;
+    for (int net = 0; net < graph.num_nets(); net++) {
+        net_clusters.clear();
+        for (int node : graph.nodes_of(net)) {
+            int c = cluster[node];
+            if (last_net[c] != net) {
+                last_net[c] = net;
+                net_clusters.push_back(c);
+            }
+        }
+        if (net_clusters.size() < 2) {
+            continue;
+        }
+        coarse.add_net("");
+        for (int c : net_clusters) {
+            coarse.add_pin(c, 0, 0);
+        }
+    }
+    coarse.finalize();
+    return coarse;
+}
+
+int multilevel_bipartition(const Hypergraph& graph, const MultilevelOptions& options, std::vector<int>& partition) {
+    bool dump = options.fm.dump_level == 0;
+    // the fixed parts are copied to the coarse levels and index the part weights, only -1, 0 and 1 are valid
+    if (options.fm.fixed_part != nullptr) {
+        const std::vector<int>& fixed_part = *options.fm.fixed_part;
+        bool valid = static_cast<int>(fixed_part.size()) == graph.num_nodes();
+        for (int node = 0; valid && node < graph.num_nodes(); node++) {
+            valid = fixed_part[node] >= -1 && fixed_part[node] <= 1;
+        }
+        if (!valid) {
+            std::cerr << "Error: the fixed parts of the multilevel bipartition must be -1, 0 or 1, one per node\n";
+            exit(1);
+        }
+    }
+    // the finest level balances sizes or node counts, the coarse levels carry the summed weights in node_size
+    std::vector<double> node_weight = options.fm.area_constraint == 0 ? std::vector<double>(graph.num_nodes(), 1.0) : graph.node_size;
+    double max_node_weight = 0;
+    double total_weight = 0;
+    for (double weight : node_weight) {
+        max_node_weight = std::max(max_node_weight, weight);
+        total_weight += weight;
+    }
+    // the balance tolerance of the finest level holds on every level
+    FMOptions fm_options = options.fm;
+    fm_options.max_imbalance = options.fm.max_imbalance >= 0 ? options.fm.max_imbalance : options.fm.max_unbalanced_nodes * max_node_weight;
+    fm_options.dump_level = -1;
+    // one pool for the FM initialization of every level
+    std::unique_ptr<ThreadPool> pool;
+    if (fm_options.pool == nullptr && fm_options.num_threads != 1) {
+        pool = std::make_unique<ThreadPool>(fm_options.num_threads);
+        fm_options.pool = pool.get();
+    }
+    // one workspace for the FM runs of every level, they run one after the other
+    std::unique_ptr<FMWorkspace> workspace;
+    if (fm_options.workspace == nullptr) {
+        workspace = std::make_unique<FMWorkspace>();
+        fm_options.workspace = workspace.get();
+    }
+    FMOptions coarse_fm_options = fm_options;
+    coarse_fm_options.area_constraint = 1;
+    // the terminals are only fixed on the finest level, the fixed_part of the coarse levels is set per level
+    coarse_fm_options.fix_terminals = false;
+    coarse_fm_options.fixed_part = nullptr;
+    // a cluster never outweighs the tolerance, so every coarse node stays movable
+    double max_cluster_weight = std::max(max_node_weight, std::min(fm_options.max_imbalance, total_weight / std::max(options.coarsest_nodes, 1)));
+
+    // ## coarsening
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<CoarseLevel> levels;
+    while (static_cast<int>(levels.size()) < options.max_levels) {
+        const Hypergraph& fine = levels.empty() ? graph : levels.back().graph;
+        const std::vector<double>& fine_weight = levels.empty() ? node_weight : levels.back().graph.node_size;
+        const std::vector<int>* fine_fixed = levels.empty() ? options.fm.fixed_part : levels.back().fixed_part.empty() ? nullptr : &levels.back().fixed_part;
+        if (fine.num_nodes() <= options.coarsest_nodes) {
+            break;
+        }
+        int num_clusters;
+        std::vector<int> cluster = cluster_nodes(fine, fine_weight, max_cluster_weight, options, options.seed + static_cast<unsigned>(levels.size()), num_clusters, fine_fixed);
+        if (num_clusters > (1 - options.min_reduction) * fine.num_nodes()) {
+            break;
+        }
+        CoarseLevel level;
+        level.graph = contract_hypergraph(fine, fine_weight, cluster, num_clusters);
+        if (fine_fixed != nullptr) {
+            // a fixed node is alone in its cluster, the cluster is fixed in the same part
+            level.fixed_part.assign(num_clusters, -1);
+            for (int node = 0; node < fine.num_nodes(); node++) {
+                level.fixed_part[cluster[node]] = std::max(level.fixed_part[cluster[node]], (*fine_fixed)[node]);
+            }
+        }
+        level.fine_to_coarse = std::move(cluster);
+        levels.push_back(std::move(level));
+        if (dump) {
+            std::cout << "Coarsening level " << levels.size() << ": " << levels.back().graph.num_nodes() << " nodes, " << levels.back().graph.num_nets() << " nets, " << levels.back().graph.num_pins() << " pins" << std::endl;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    if (dump) {
+        std::cout << "Time to coarsen in multilevel: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+    }
+    if (options.fm.metrics != nullptr) {
+        options.fm.metrics->record_phase("multilevel_coarsen", start, end);
+    }
+
+    // ## initial partition of the coarsest level, best of several random balanced starts refined with FM
+    start = std::chrono::high_resolution_clock::now();
+    const Hypergraph& coarsest = levels.empty() ? graph : levels.back().graph;
+    const std::vector<double>& coarsest_weight = levels.empty() ? node_weight : coarsest.node_size;
+    FMOptions coarsest_fm_options = levels.empty() ? fm_options : coarse_fm_options;
+    if (!levels.empty() && !levels.back().fixed_part.empty()) {
+        coarsest_fm_options.fixed_part = &levels.back().fixed_part;
+    }
+    const std::vector<int>* coarsest_fixed = coarsest_fm_options.fixed_part;
+    std::mt19937 rng(options.seed);
+    std::vector<int> order(coarsest.num_nodes());
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<int> best_partition;
+    int best_cut = -1;
+    for (int t = 0; t < std::max(options.initial_tries, 1); t++) {
+        // random order, each node goes to the part that is lighter relative to its target
+        std::shuffle(order.begin(), order.end(), rng);
+        std::vector<int> try_partition(coarsest.num_nodes(), 0);
+        double part_weight[2] = {0, 0};
+        // the fixed nodes go first, the free ones fill the parts around them
+        if (coarsest_fixed != nullptr) {
+            for (int node = 0; node < coarsest.num_nodes(); node++) {
+                if ((*coarsest_fixed)[node] >= 0) {
+                    try_partition[node] = (*coarsest_fixed)[node];
+                    part_weight[try_partition[node]] += coarsest_weight[node];
+                }
+            }
+        }
+        for (int node : order) {
+            if (coarsest_fixed != nullptr && (*coarsest_fixed)[node] >= 0) {
+                continue;
+            }
+            int part = part_weight[0] * (1 - fm_options.target_fraction) <= part_weight[1] * fm_options.target_fraction ? 0 : 1;
+            try_partition[node] = part;
+            part_weight[part] += coarsest_weight[node];
+        }
+        FMBipartitioner bipartitioner(coarsest, coarsest_fm_options);
+        int cut = bipartitioner.run(try_partition);
+        if (best_cut < 0 || cut < best_cut) {
+            best_cut = cut;
+            best_partition = std::move(try_partition);
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    if (dump) {
+        std::cout << "Initial partition: cut " << best_cut << ", best of " << std::max(options.initial_tries, 1) << " tries on " << coarsest.num_nodes() << " nodes, " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+    }
+    if (options.fm.metrics != nullptr) {
+        options.fm.metrics->record_phase("multilevel_initial_partition", start, end);
+    }
+
+    // ## uncoarsening, project the partition to the finer level and refine it
+    int cut = best_cut;
+    partition = std::move(best_partition);
+    for (int l = static_cast<int>(levels.size()) - 1; l >= 0; l--) {
+        start = std::chrono::high_resolution_clock::now();
+        const Hypergraph& fine = l == 0 ? graph : levels[l - 1].graph;
+        const std::vector<int>& fine_to_coarse = levels[l].fine_to_coarse;
+        std::vector<int> fine_partition(fine.num_nodes());
+        for (int node = 0; node < fine.num_nodes(); node++) {
+            fine_partition[node] = partition[fine_to_coarse[node]];
+        }
+        partition = std::move(fine_partition);
+        FMOptions level_fm_options = l == 0 ? fm_options : coarse_fm_options;
+        if (l > 0 && !levels[l - 1].fixed_part.empty()) {
+            level_fm_options.fixed_part = &levels[l - 1].fixed_part;
+        }
+        FMBipartitioner bipartitioner(fine, level_fm_options);
+        int projected_cut = cut;
+        cut = bipartitioner.run(partition);
+        end = std::chrono::high_resolution_clock::now();
+        if (dump) {
+            std::cout << "Refine level " << l << ": " << fine.num_nodes() << " nodes, cut " << projected_cut << " -> " << cut << ", " << bipartitioner.pass_stats().size() << " passes, " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+        }
+        if (options.fm.metrics != nullptr) {
+            options.fm.metrics->record_phase("multilevel_refine_level", start, end);
+        }
+    }
+    if (dump) {
+        const FMWorkspaceStats& workspace_stats = fm_options.workspace->statistics();
+        std::cout << "FM workspace: " << workspace_stats.runs << " runs, " << workspace_stats.allocations << " buffer allocations, peak " << workspace_stats.peak_scratch_bytes << " bytes of scratch" << std::endl;
+    }
+    return cut;
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+#include "../include/multistart.h"
+#include "../include/thread_pool.h"
+
+MultiStartOptions::MultiStartOptions() : num_starts(8), num_threads(0), seed(13), cancel_margin(-1) {}
+
+MultiStartResult multi_start_bipartition(const Hypergraph& graph, const MultiStartOptions& options) {
+    auto start = std::chrono::high_resolution_clock::now();
+    int num_starts = std::max(options.num_starts, 1);
+    MultiStartResult result;
+    result.start_cut = std::vector<int>(num_starts, 0);
+    result.start_passes = std::vector<int>(num_starts, 0);
+    result.start_cancelled = std::vector<char>(num_starts, false);
+    result.start_time_ms = std::vector<double>(num_starts, 0);
+    std::vector<std::vector<int> > start_partition(num_starts);
+    // best cut of any start after each pass, for the cancellation
+    std::vector<std::atomic<int> > best_pass_cut(std::max(options.fm.max_passes, 0) + 1);
+    for (std::atomic<int>& cut : best_pass_cut) {
+        cut = -1;
+    }
+
+    ThreadPool pool(options.num_threads);
+    TaskGroup group;
+    for (int s = 0; s < num_starts; s++) {
+        pool.submit(group, [&, s] {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            FMOptions fm_options = options.fm;
+            fm_options.dump_level = -1;
+            // the starts already keep the threads busy, initialize each one serially
+            fm_options.num_threads = 1;
+            fm_options.pool = nullptr;
+            // the starts run at once, a workspace serves one FMBipartitioner at a time
+            fm_options.workspace = nullptr;
+            // random order, each node goes to the lighter part
+            std::vector<int> order(graph.num_nodes());
+            std::iota(order.begin(), order.end(), 0);
+            std::mt19937 rng(options.seed + static_cast<unsigned>(s));
+            std::shuffle(order.begin(), order.end(), rng);
+            std::vector<int> partition(graph.num_nodes(), 0);
+            double part_weight[2] = {0, 0};
+            for (int node : order) {
+                int part = part_weight[0] <= part_weight[1] ? 0 : 1;
+                partition[node] = part;
+                part_weight[part] += fm_options.area_constraint == 0 ? 1.0 : graph.node_size[node];
+            }
+
+            FMBipartitioner bipartitioner(graph, fm_options);
+            if (options.cancel_margin >= 0) {
+                bipartitioner.set_pass_callback([&](const FMPassStats& pass_stats) {
+                    std::atomic<int>& best_cut = best_pass_cut[pass_stats.pass];
+                    int best = best_cut.load();
+                    while ((best < 0 || pass_stats.cut_after < best) && !best_cut.compare_exchange_weak(best, pass_stats.cut_after)) {
+                    }
+                    best = best_cut.load();
+                    if (pass_stats.pass >= 2 && pass_stats.cut_after > (1 + options.cancel_margin) * best) {
+                        result.start_cancelled[s] = true;
+                        return false;
+                    }
+                    return true;
+                });
+            }
+            int cut = bipartitioner.run(partition);
+            result.start_cut[s] = cut;
+            result.start_passes[s] = static_cast<int>(bipartitioner.pass_stats().size());
+            start_partition[s] = std::move(partition);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            if (options.fm.metrics != nullptr) {
+                options.fm.metrics->record_phase("multistart_start", start_time, end_time);
+            }
+            result.start_time_ms[s] = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        });
+    }
+    pool.wait(group);
+
+    result.best_start = 0;
+    for (int s = 1; s < num_starts; s++) {
+        if (result.start_cut[s] < result.start_cut[result.best_start]) {
+            result.best_start = s;
+        }
+    }
+    result.cut = result.start_cut[result.best_start];
+    result.partition = std::move(start_partition[result.best_start]);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    if (options.fm.dump_level == 0) {
+        for (int s = 0; s < num_starts; s++) {
+            std::cout << "Start " << s << " (seed " << options.seed + static_cast<unsigned>(s) << "): cut " << result.start_cut[s] << ", " << result.start_passes[s] << " passes, " << static_cast<long long>(result.start_time_ms[s]) << " ms" << (result.start_cancelled[s] ? ", cancelled" : "") << std::endl;
+        }
+        std::vector<int> cuts = result.start_cut;
+        std::sort(cuts.begin(), cuts.end());
+        double mean = std::accumulate(cuts.begin(), cuts.end(), 0.0) / num_starts;
+        int cancelled = static_cast<int>(std::count(result.start_cancelled.begin(), result.start_cancelled.end(), true));
+        std::cout << "Multi-start cut: min " << cuts.front() << ", median " << cuts[num_starts / 2] << ", mean " << mean << ", max " << cuts.back() << ", best start " << result.best_start << ", " << cancelled << " cancelled" << std::endl;
+        std::cout << "Time to run " << num_starts << " FM starts on " << pool.num_threads() << " threads: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+    }
+    return result;
+}
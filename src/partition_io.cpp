@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <memory>
+
+#include "../include/bookshelf.h"
+#include "../include/partition_io.h"
+#include "../include/text_io.h"
+#include "../include/thread_pool.h"
+
+namespace {
+
+// lines of a formatting chunk, large enough to amortize a task, small enough to balance the threads
+const int lines_per_chunk = 16384;
+
+// open the file, write its lines with write_parallel and close it
+bool write_lines(const std::string& file_dir, int count, int num_threads, std::string& error, const std::function<void(TextBuffer&, int, int)>& format) {
+    TextWriter writer;
+    if (!writer.open(file_dir)) {
+        error = "cannot open file " + file_dir;
+        return false;
+    }
+    std::unique_ptr<ThreadPool> pool;
+    if (num_threads != 1) {
+        pool = std::make_unique<ThreadPool>(num_threads);
+    }
+    write_parallel(writer, count, lines_per_chunk, pool.get(), format);
+    if (!writer.close()) {
+        error = "cannot write file " + file_dir;
+        return false;
+    }
+    return true;
+}
+
+}
+
+bool read_partition_file(const std::string& file_dir, const Hypergraph& graph, std::vector<int>& partition, std::string& error, bool every_node, int num_parts) {
+    MappedFile file;
+    if (!file.open(file_dir)) {
+        error = "cannot open file " + file_dir;
+        return false;
+    }
+    TextScanner scanner(file.begin(), file.end());
+    partition.assign(graph.num_nodes(), -1);
+    int assigned = 0;
+    while (!scanner.at_end()) {
+        std::string_view name = scanner.token();
+        if (name[0] == '#') {
+            scanner.skip_line();
+            continue;
+        }
+        int part;
+        int node = graph.node_names.find(name);
+        if (!scanner.parse_int(part) || part < 0) {
+            error = "expected <node name> <part> at line " + std::to_string(line_number_of(file.begin(), scanner.cur)) + " of file " + file_dir;
+            return false;
+        }
+        if (num_parts > 0 && part >= num_parts) {
+            error = "part " + std::to_string(part) + " out of range [0, " + std::to_string(num_parts) + ") at line " + std::to_string(line_number_of(file.begin(), scanner.cur)) + " of file " + file_dir;
+            return false;
+        }
+        // nodes that are not in the graph any more, e.g. removed by an ECO, are skipped
+        if (node < 0) {
+            continue;
+        }
+        assigned += partition[node] < 0;
+        partition[node] = part;
+    }
+    if (every_node && assigned != graph.num_nodes()) {
+        error = std::to_string(graph.num_nodes() - assigned) + " nodes have no part in file " + file_dir;
+        return false;
+    }
+    return true;
+}
+
+bool write_partition_file(const std::string& file_dir, const Hypergraph& graph, const std::vector<int>& partition, std::string& error, int num_threads) {
+    return write_lines(file_dir, graph.num_nodes(), num_threads, error, [&](TextBuffer& buffer, int begin, int end) {
+        for (int node = begin; node < end; node++) {
+            buffer << graph.node_names[node] << ' ' << partition[node] << '\n';
+        }
+    });
+}
+
+bool write_hmetis_partition_file(const std::string& file_dir, const std::vector<int>& partition, std::string& error, int num_threads) {
+    return write_lines(file_dir, static_cast<int>(partition.size()), num_threads, error, [&](TextBuffer& buffer, int begin, int end) {
+        for (int node = begin; node < end; node++) {
+            buffer << partition[node] << '\n';
+        }
+    });
+}
+
+bool write_cut_nets_file(const std::string& file_dir, const Hypergraph& graph, const std::vector<int>& partition, std::string& error, int num_threads) {
+    return write_lines(file_dir, graph.num_nets(), num_threads, error, [&](TextBuffer& buffer, int begin, int end) {
+        std::vector<int> parts;
+        for (int net = begin; net < end; net++) {
+            parts.clear();
+            for (int node : graph.nodes_of(net)) {
+                parts.push_back(partition[node]);
+            }
+            std::sort(parts.begin(), parts.end());
+            parts.erase(std::unique(parts.begin(), parts.end()), parts.end());
+            if (parts.size() < 2) {
+                continue;
+            }
+            buffer << graph.net_names[net] << ' ' << static_cast<int>(graph.nodes_of(net).size());
+            for (int part : parts) {
+                buffer << ' ' << part;
+            }
+            buffer << '\n';
+        }
+    });
+}
+
+bool write_part_designs(const std::string& base, const Hypergraph& graph, const std::vector<int>& partition, int num_parts, std::string& error, int num_threads) {
+    for (int part = 0; part < num_parts; part++) {
+        if (!write_bookshelf(base + "_" + std::to_string(part) + ".aux", graph.extract(partition, part), error, num_threads)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <memory>
+
+#include "../include/bookshelf.h"
+#include "../include/placement.h"
+#include "../include/text_io.h"
+#include "../include/thread_pool.h"
+
+bool read_bookshelf_scl(const std::string& scl_file_dir, std::vector<PlacementRow>& rows, std::string& error) {
+    MappedFile file;
+    if (!file.open(scl_file_dir)) {
+        error = "cannot open file " + scl_file_dir;
+        return false;
+    }
+    TextScanner scanner(file.begin(), file.end());
+    auto fail = [&](const std::string& message) {
+        error = message + " at line " + std::to_string(line_number_of(file.begin(), scanner.cur)) + " of file " + scl_file_dir;
+        return false;
+    };
+    rows.clear();
+    // CoreRow Horizontal
+    //   Coordinate : 0
+    //   Height : 9
+    //   Sitewidth : 1
+    //   Sitespacing : 1
+    //   Siteorient : N
+    //   Sitesymmetry : Y
+    //   SubrowOrigin : 0  NumSites : 5741
+    // End
+    bool in_row = false;
+    PlacementRow row;
+    double num_sites = 0;
+    while (!scanner.at_end()) {
+        std::string_view key = scanner.token();
+        if (key[0] == '#' || key == "UCLA" || key == "NumRows" || key == "Siteorient" || key == "Sitesymmetry") {
+            scanner.skip_line();
+            continue;
+        }
+        if (key == "CoreRow") {
+            row = PlacementRow{0, 0, 1, 1, 0, 0};
+            num_sites = 0;
+            in_row = true;
+            scanner.skip_line();
+            continue;
+        }
+        if (!in_row) {
+            return fail("expected CoreRow but found " + std::string(key));
+        }
+        if (key == "End") {
+            row.x_max = row.x_min + num_sites * row.site_spacing;
+            rows.push_back(row);
+            in_row = false;
+            continue;
+        }
+        double* value = key == "Coordinate" ? &row.y : key == "Height" ? &row.height : key == "Sitewidth" ? &row.site_width : key == "Sitespacing" ? &row.site_spacing : key == "SubrowOrigin" ? &row.x_min : key == "NumSites" ? &num_sites : nullptr;
+        if (value == nullptr) {
+            return fail("unknown row key " + std::string(key));
+        }
+        if (scanner.token_in_line() != ":" || !scanner.parse_double(*value)) {
+            return fail("expected " + std::string(key) + " : <value>");
+        }
+    }
+    if (in_row) {
+        return fail("missing End of the last CoreRow");
+    }
+    std::stable_sort(rows.begin(), rows.end(), [](const PlacementRow& a, const PlacementRow& b) { return a.y < b.y; });
+    return true;
+}
+
+bool read_bookshelf_pl(const std::string& pl_file_dir, const Hypergraph& graph, Placement& placement, std::string& error) {
+    MappedFile file;
+    if (!file.open(pl_file_dir)) {
+        error = "cannot open file " + pl_file_dir;
+        return false;
+    }
+    TextScanner scanner(file.begin(), file.end());
+    placement.x.assign(graph.num_nodes(), 0);
+    placement.y.assign(graph.num_nodes(), 0);
+    placement.fixed.assign(graph.num_nodes(), false);
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        placement.fixed[node] = graph.node_type[node] != NodeTypeEnum::node;
+    }
+    while (!scanner.at_end()) {
+        const char* line = scanner.cur;
+        std::string_view name = scanner.token();
+        if (name[0] == '#' || name == "UCLA") {
+            scanner.skip_line();
+            continue;
+        }
+        int node = graph.node_names.find(name);
+        if (node < 0) {
+            error = "unknown node " + std::string(name) + " at line " + std::to_string(line_number_of(file.begin(), line)) + " of file " + pl_file_dir;
+            return false;
+        }
+        if (!scanner.parse_double(placement.x[node]) || !scanner.parse_double(placement.y[node])) {
+            error = "expected <name> <x> <y> at line " + std::to_string(line_number_of(file.begin(), line)) + " of file " + pl_file_dir;
+            return false;
+        }
+        // the orientation and the fixed flag are optional
+        for (std::string_view t = scanner.token_in_line(); !t.empty(); t = scanner.token_in_line()) {
+            if (t == "/FIXED" || t == "/FIXED_NI") {
+                placement.fixed[node] = true;
+            }
+        }
+    }
+    return true;
+}
+
+bool write_bookshelf_pl(const std::string& pl_file_dir, const Hypergraph& graph, const Placement& placement, std::string& error, int num_threads) {
+    TextWriter writer;
+    if (!writer.open(pl_file_dir)) {
+        error = "cannot open file " + pl_file_dir;
+        return false;
+    }
+    std::unique_ptr<ThreadPool> pool;
+    if (num_threads != 1) {
+        pool = std::make_unique<ThreadPool>(num_threads);
+    }
+    writer << "UCLA pl 1.0\n\n";
+    write_parallel(writer, graph.num_nodes(), 16384, pool.get(), [&](TextBuffer& buffer, int begin, int end) {
+        for (int node = begin; node < end; node++) {
+            buffer << graph.node_names[node] << '\t' << placement.x[node] << '\t' << placement.y[node] << (placement.fixed[node] ? "\t: N /FIXED\n" : "\t: N\n");
+        }
+    });
+    if (!writer.close()) {
+        error = "cannot write file " + pl_file_dir;
+        return false;
+    }
+    return true;
+}
+
+bool load_bookshelf_placement(const std::string& aux_file_dir, const Hypergraph& graph, Placement& placement, std::string& error) {
+    BookshelfFiles files = read_bookshelf_aux(aux_file_dir);
+    return read_bookshelf_scl(files.scl, placement.rows, error) && read_bookshelf_pl(files.pl, graph, placement, error);
+}
+
+double net_hpwl(const Hypergraph& graph, const Placement& placement, int net) {
+    int first = graph.net_pin_offsets[net];
+    int last = graph.net_pin_offsets[net + 1];
+    if (last - first < 2) {
+        return 0;
+    }
+    double x_min = 1e300;
+    double x_max = -1e300;
+    double y_min = 1e300;
+    double y_max = -1e300;
+    for (int pin = first; pin < last; pin++) {
+        int node = graph.pin_node[pin];
+        double x = placement.x[node] + graph.node_width[node] / 2 + graph.pin_delta_width[pin];
+        double y = placement.y[node] + graph.node_height[node] / 2 + graph.pin_delta_height[pin];
+        x_min = std::min(x_min, x);
+        x_max = std::max(x_max, x);
+        y_min = std::min(y_min, y);
+        y_max = std::max(y_max, y);
+    }
+    return (x_max - x_min) + (y_max - y_min);
+}
+
+double total_hpwl(const Hypergraph& graph, const Placement& placement) {
+    double hpwl = 0;
+    for (int net = 0; net < graph.num_nets(); net++) {
+        hpwl += net_hpwl(graph, placement, net);
+    }
+    return hpwl;
+}
@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "../include/fm.h"
+#include "../include/quadratic.h"
+
+namespace {
+
+// side of the density bins in rows
+const double bin_rows = 8;
+
+// regions with at most this many nodes are not bisected further
+const int min_region_nodes = 8;
+
+// regions with more nodes bisect their halves in parallel
+const int parallel_region_nodes = 4096;
+
+// an end of a connection: a variable and the offset of the pin from it, or a fixed position
+struct Endpoint {
+public:
+    int variable; // -1 for a fixed position
+    double x;
+    double y;
+};
+
+double overlap(double low, double high, double other_low, double other_high) {
+    return std::max(0.0, std::min(high, other_high) - std::max(low, other_low));
+}
+
+}
+
+QuadraticOptions::QuadraticOptions() : clique_max_degree(3), center_weight(1e-4), spreading_levels(10), spreading_imbalance(0.05), anchor_weight(0.5), num_threads(0), dump_level(0), metrics(nullptr) {}
+
+QuadraticPlacer::QuadraticPlacer(const Hypergraph& graph, Placement& placement, const QuadraticOptions& options) : graph(graph), options(options), placement(placement), core_x_min(0), core_x_max(0), core_y_min(0), core_y_max(0), row_height(0), bin_size(1), bins_x(0), bins_y(0) {
+    if (options.num_threads != 1) {
+        pool = std::make_unique<ThreadPool>(options.num_threads);
+    }
+    int num_nodes = graph.num_nodes();
+    const std::vector<PlacementRow>& rows = placement.rows;
+    if (!rows.empty()) {
+        core_x_min = rows[0].x_min;
+        core_x_max = rows[0].x_max;
+        core_y_min = rows[0].y;
+        core_y_max = rows[0].y + rows[0].height;
+    }
+    for (const PlacementRow& row : rows) {
+        core_x_min = std::min(core_x_min, row.x_min);
+        core_x_max = std::max(core_x_max, row.x_max);
+        core_y_min = std::min(core_y_min, row.y);
+        core_y_max = std::max(core_y_max, row.y + row.height);
+        row_height = std::max(row_height, row.height);
+    }
+
+    // ## movable nodes and blockages
+    node_variable.assign(num_nodes, -1);
+    for (int node = 0; node < num_nodes; node++) {
+        bool fits = graph.node_height[node] <= row_height && graph.node_width[node] <= core_x_max - core_x_min;
+        if (!placement.fixed[node] && fits) {
+            node_variable[node] = static_cast<int>(movable.size());
+            movable.push_back(node);
+        }
+        else if (overlap(placement.x[node], placement.x[node] + graph.node_width[node], core_x_min, core_x_max) > 0 && overlap(placement.y[node], placement.y[node] + graph.node_height[node], core_y_min, core_y_max) > 0) {
+            blockages.push_back(node);
+        }
+    }
+
+    // ## capacity of the density bins: the row area they cover, less the blockages
+    bin_size = std::max(row_height, 1.0) * bin_rows;
+    bins_x = std::max(1, static_cast<int>(std::ceil((core_x_max - core_x_min) / bin_size)));
+    bins_y = std::max(1, static_cast<int>(std::ceil((core_y_max - core_y_min) / bin_size)));
+    bin_capacity.assign(static_cast<size_t>(bins_x) * bins_y, 0);
+    auto add_area = [&](double x_low, double x_high, double y_low, double y_high, double sign) {
+        int first_x = std::max(0, static_cast<int>((x_low - core_x_min) / bin_size));
+        int first_y = std::max(0, static_cast<int>((y_low - core_y_min) / bin_size));
+        for (int by = first_y; by < bins_y && core_y_min + by * bin_size < y_high; by++) {
+            double y_overlap = overlap(y_low, y_high, core_y_min + by * bin_size, core_y_min + (by + 1) * bin_size);
+            for (int bx = first_x; bx < bins_x && core_x_min + bx * bin_size < x_high; bx++) {
+                bin_capacity[static_cast<size_t>(by) * bins_x + bx] += sign * y_overlap * overlap(x_low, x_high, core_x_min + bx * bin_size, core_x_min + (bx + 1) * bin_size);
+            }
+        }
+    };
+    for (const PlacementRow& row : rows) {
+        add_area(row.x_min, row.x_max, row.y, row.y + row.height, 1);
+    }
+    for (int node : blockages) {
+        add_area(placement.x[node], placement.x[node] + graph.node_width[node], placement.y[node], placement.y[node] + graph.node_height[node], -1);
+    }
+    for (double& capacity : bin_capacity) {
+        capacity = std::max(0.0, capacity);
+    }
+}
+
+void QuadraticPlacer::_assemble() {
+    int num_movable = static_cast<int>(movable.size());
+    star_net.clear();
+    for (int net = 0; net < graph.num_nets(); net++) {
+        if (graph.net_pin_offsets[net + 1] - graph.net_pin_offsets[net] > std::max(options.clique_max_degree, 1)) {
+            star_net.push_back(net);
+        }
+    }
+    int num_variables = num_movable + static_cast<int>(star_net.size());
+    SparseMatrixBuilder builder(num_variables);
+    rhs_x.assign(num_variables, 0);
+    rhs_y.assign(num_variables, 0);
+    // a movable pin is its node variable plus its offset from the center, a fixed pin is at its position
+    auto endpoint = [&](int pin) {
+        int node = graph.pin_node[pin];
+        if (node_variable[node] >= 0) {
+            return Endpoint{node_variable[node], graph.pin_delta_width[pin], graph.pin_delta_height[pin]};
+        }
+        return Endpoint{-1, placement.x[node] + graph.node_width[node] / 2 + graph.pin_delta_width[pin], placement.y[node] + graph.node_height[node] / 2 + graph.pin_delta_height[pin]};
+    };
+    // weight * ((a + a offset) - (b + b offset))^2
+    auto connect = [&](const Endpoint& a, const Endpoint& b, double weight) {
+        if (a.variable >= 0 && b.variable >= 0) {
+            if (a.variable == b.variable) {
+                return;
+            }
+            builder.add_diagonal(a.variable, weight);
+            builder.add_diagonal(b.variable, weight);
+            builder.add_symmetric(a.variable, b.variable, -weight);
+            rhs_x[a.variable] += weight * (b.x - a.x);
+            rhs_y[a.variable] += weight * (b.y - a.y);
+            rhs_x[b.variable] += weight * (a.x - b.x);
+            rhs_y[b.variable] += weight * (a.y - b.y);
+        }
+        else if (a.variable >= 0 || b.variable >= 0) {
+            const Endpoint& free = a.variable >= 0 ? a : b;
+            const Endpoint& fixed = a.variable >= 0 ? b : a;
+            builder.add_diagonal(free.variable, weight);
+            rhs_x[free.variable] += weight * (fixed.x - free.x);
+            rhs_y[free.variable] += weight * (fixed.y - free.y);
+        }
+    };
+    int star = num_movable;
+    for (int net = 0; net < graph.num_nets(); net++) {
+        int first = graph.net_pin_offsets[net];
+        int last = graph.net_pin_offsets[net + 1];
+        int num_pins = last - first;
+        if (num_pins < 2) {
+            continue;
+        }
+        if (star < num_variables && star_net[star - num_movable] == net) {
+            Endpoint center{star, 0, 0};
+            for (int pin = first; pin < last; pin++) {
+                connect(center, endpoint(pin), static_cast<double>(num_pins) / (num_pins - 1));
+            }
+            star++;
+            continue;
+        }
+        for (int pin = first; pin < last; pin++) {
+            Endpoint a = endpoint(pin);
+            for (int other = pin + 1; other < last; other++) {
+                connect(a, endpoint(other), 1.0 / (num_pins - 1));
+            }
+        }
+    }
+    double center_x = (core_x_min + core_x_max) / 2;
+    double center_y = (core_y_min + core_y_max) / 2;
+    for (int variable = 0; variable < num_movable; variable++) {
+        builder.add_diagonal(variable, options.center_weight);
+        rhs_x[variable] += options.center_weight * center_x;
+        rhs_y[variable] += options.center_weight * center_y;
+    }
+    matrix = builder.build(pool.get());
+}
+
+void QuadraticPlacer::_solve(const std::vector<double>& anchor_weight, const std::vector<double>& anchor_x, const std::vector<double>& anchor_y, QuadraticResult& result) {
+    int num_movable = static_cast<int>(movable.size());
+    std::vector<double> diagonal = matrix.diagonal;
+    std::vector<double> b_x = rhs_x;
+    std::vector<double> b_y = rhs_y;
+    if (!anchor_weight.empty()) {
+        for (int node : movable) {
+            int variable = node_variable[node];
+            matrix.diagonal[variable] += anchor_weight[node];
+            b_x[variable] += anchor_weight[node] * anchor_x[node];
+            b_y[variable] += anchor_weight[node] * anchor_y[node];
+        }
+    }
+    // start from the current centers, and the stars from the center of their pins
+    std::vector<double> x(matrix.num_rows);
+    std::vector<double> y(matrix.num_rows);
+    for (int node : movable) {
+        x[node_variable[node]] = placement.x[node] + graph.node_width[node] / 2;
+        y[node_variable[node]] = placement.y[node] + graph.node_height[node] / 2;
+    }
+    for (int star = num_movable; star < matrix.num_rows; star++) {
+        IdRange nodes = graph.nodes_of(star_net[star - num_movable]);
+        x[star] = y[star] = 0;
+        for (int node : nodes) {
+            x[star] += placement.x[node] + graph.node_width[node] / 2;
+            y[star] += placement.y[node] + graph.node_height[node] / 2;
+        }
+        x[star] /= nodes.size();
+        y[star] /= nodes.size();
+    }
+    ConjugateGradientResult solved_x = conjugate_gradient(matrix, b_x, x, options.solver, pool.get());
+    ConjugateGradientResult solved_y = conjugate_gradient(matrix, b_y, y, options.solver, pool.get());
+    matrix.diagonal = std::move(diagonal);
+    result.iterations_x = solved_x.iterations;
+    result.iterations_y = solved_y.iterations;
+    for (int node : movable) {
+        placement.x[node] = x[node_variable[node]] - graph.node_width[node] / 2;
+        placement.y[node] = y[node_variable[node]] - graph.node_height[node] / 2;
+    }
+}
+
+double QuadraticPlacer::_capacity(double x_min, double x_max, double y_min, double y_max) const {
+    double capacity = 0;
+    for (const PlacementRow& row : placement.rows) {
+        capacity += overlap(row.x_min, row.x_max, x_min, x_max) * overlap(row.y, row.y + row.height, y_min, y_max);
+    }
+    for (int node : blockages) {
+        capacity -= overlap(placement.x[node], placement.x[node] + graph.node_width[node], x_min, x_max) * overlap(placement.y[node], placement.y[node] + graph.node_height[node], y_min, y_max);
+    }
+    return std::max(0.0, capacity);
+}
+
+double QuadraticPlacer::_overflow() const {
+    std::vector<double> bin_area(bin_capacity.size(), 0);
+    double total_area = 0;
+    for (int node : movable) {
+        int bx = static_cast<int>((placement.x[node] + graph.node_width[node] / 2 - core_x_min) / bin_size);
+        int by = static_cast<int>((placement.y[node] + graph.node_height[node] / 2 - core_y_min) / bin_size);
+        bx = std::min(std::max(bx, 0), bins_x - 1);
+        by = std::min(std::max(by, 0), bins_y - 1);
+        bin_area[static_cast<size_t>(by) * bins_x + bx] += graph.node_size[node];
+        total_area += graph.node_size[node];
+    }
+    double overflow = 0;
+    for (size_t bin = 0; bin < bin_area.size(); bin++) {
+        overflow += std::max(0.0, bin_area[bin] - bin_capacity[bin]);
+    }
+    return total_area > 0 ? overflow / total_area : 0;
+}
+
+void QuadraticPlacer::_bisect(Region& region, int level, std::vector<double>& target_x, std::vector<double>& target_y) const {
+    int num_region_nodes = static_cast<int>(region.nodes.size());
+    auto center_x = [&](int node) { return placement.x[node] + graph.node_width[node] / 2; };
+    auto center_y = [&](int node) { return placement.y[node] + graph.node_height[node] / 2; };
+    if (level == 0 || num_region_nodes <= min_region_nodes) {
+        // ## leaf: stretch the box of the centers of the nodes over the region
+        double x_low = 1e300;
+        double x_high = -1e300;
+        double y_low = 1e300;
+        double y_high = -1e300;
+        for (int node : region.nodes) {
+            x_low = std::min(x_low, center_x(node));
+            x_high = std::max(x_high, center_x(node));
+            y_low = std::min(y_low, center_y(node));
+            y_high = std::max(y_high, center_y(node));
+        }
+        for (int node : region.nodes) {
+            double fx = x_high > x_low ? (center_x(node) - x_low) / (x_high - x_low) : 0.5;
+            double fy = y_high > y_low ? (center_y(node) - y_low) / (y_high - y_low) : 0.5;
+            double half_width = std::min(graph.node_width[node], region.x_max - region.x_min) / 2;
+            double half_height = std::min(graph.node_height[node], region.y_max - region.y_min) / 2;
+            target_x[node] = region.x_min + half_width + fx * (region.x_max - region.x_min - 2 * half_width);
+            target_y[node] = region.y_min + half_height + fy * (region.y_max - region.y_min - 2 * half_height);
+        }
+        return;
+    }
+
+    // ## cut the longer side in the middle, the halves get the nodes in proportion to their capacity
+    bool vertical_cut = region.x_max - region.x_min >= region.y_max - region.y_min;
+    Region halves[2];
+    for (Region& half : halves) {
+        half.x_min = region.x_min;
+        half.x_max = region.x_max;
+        half.y_min = region.y_min;
+        half.y_max = region.y_max;
+    }
+    if (vertical_cut) {
+        halves[0].x_max = halves[1].x_min = (region.x_min + region.x_max) / 2;
+    }
+    else {
+        halves[0].y_max = halves[1].y_min = (region.y_min + region.y_max) / 2;
+    }
+    double capacity[2];
+    for (int part = 0; part < 2; part++) {
+        capacity[part] = _capacity(halves[part].x_min, halves[part].x_max, halves[part].y_min, halves[part].y_max);
+    }
+    double fraction = capacity[0] + capacity[1] > 0 ? capacity[0] / (capacity[0] + capacity[1]) : 0.5;
+
+    // ## initial split at the capacity weighted median of the coordinate across the cut
+    std::vector<int> order(num_region_nodes);
+    for (int i = 0; i < num_region_nodes; i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        int node_a = region.nodes[a];
+        int node_b = region.nodes[b];
+        return vertical_cut ? center_x(node_a) < center_x(node_b) : center_y(node_a) < center_y(node_b);
+    });
+    double total_area = 0;
+    double max_node_area = 0;
+    for (int node : region.nodes) {
+        total_area += graph.node_size[node];
+        max_node_area = std::max(max_node_area, graph.node_size[node]);
+    }
+    std::vector<int> part(num_region_nodes, 1);
+    double area = 0;
+    for (int i : order) {
+        if (area >= fraction * total_area) {
+            break;
+        }
+        part[i] = 0;
+        area += graph.node_size[region.nodes[i]];
+    }
+
+    // ## min-cut refinement of the split
+    if (region.graph.num_nets() > 0 && total_area > 0) {
+        FMOptions fm_options;
+        fm_options.area_constraint = 1;
+        fm_options.target_fraction = fraction;
+        fm_options.max_imbalance = std::max(options.spreading_imbalance * total_area, max_node_area);
+        fm_options.max_passes = 10;
+        fm_options.dump_level = -1;
+        fm_options.num_threads = 1;
+        FMBipartitioner bipartitioner(region.graph, fm_options);
+        bipartitioner.run(part);
+    }
+    for (int p = 0; p < 2; p++) {
+        for (int i = 0; i < num_region_nodes; i++) {
+            if (part[i] == p) {
+                halves[p].nodes.push_back(region.nodes[i]);
+            }
+        }
+        halves[p].graph = region.graph.extract(part, p, 2);
+    }
+    region.graph = Hypergraph();
+    region.nodes = std::vector<int>();
+
+    // ## the halves do not share nodes, the larger regions bisect them in parallel
+    if (pool != nullptr && num_region_nodes > parallel_region_nodes) {
+        TaskGroup group;
+        pool->submit(group, [&]() { _bisect(halves[1], level - 1, target_x, target_y); });
+        _bisect(halves[0], level - 1, target_x, target_y);
+        pool->wait(group);
+    }
+    else {
+        _bisect(halves[0], level - 1, target_x, target_y);
+        _bisect(halves[1], level - 1, target_x, target_y);
+    }
+}
+
+void QuadraticPlacer::_spread(std::vector<double>& target_x, std::vector<double>& target_y) const {
+    Region core;
+    core.x_min = core_x_min;
+    core.x_max = core_x_max;
+    core.y_min = core_y_min;
+    core.y_max = core_y_max;
+    core.nodes = movable;
+    std::vector<int> part_of(graph.num_nodes(), 1);
+    for (int node : movable) {
+        part_of[node] = 0;
+    }
+    core.graph = graph.extract(part_of, 0, 2);
+    target_x.assign(graph.num_nodes(), 0);
+    target_y.assign(graph.num_nodes(), 0);
+    _bisect(core, options.spreading_levels, target_x, target_y);
+}
+
+QuadraticResult QuadraticPlacer::run() {
+    QuadraticResult result;
+    result.iterations_x = result.iterations_y = 0;
+    result.spread_ms = 0;
+    result.initial_hpwl = total_hpwl(graph, placement);
+    bool dump = options.dump_level >= 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    _assemble();
+    auto end = std::chrono::high_resolution_clock::now();
+    result.num_variables = matrix.num_rows;
+    result.num_entries = matrix.num_entries();
+    result.assemble_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    if (options.metrics != nullptr) {
+        options.metrics->record_phase("quadratic_assemble", start, end);
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    _solve({}, {}, {}, result);
+    end = std::chrono::high_resolution_clock::now();
+    result.solve_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    if (options.metrics != nullptr) {
+        options.metrics->record_phase("quadratic_solve", start, end);
+    }
+    result.solved_hpwl = result.spread_hpwl = result.hpwl = total_hpwl(graph, placement);
+    result.solved_overflow = result.overflow = _overflow();
+    if (dump) {
+        std::cout << "Quadratic solve: " << movable.size() << " movable nodes, " << result.num_variables << " variables, " << result.num_entries << " entries, " << result.iterations_x << " + " << result.iterations_y << " iterations, hpwl " << static_cast<long long>(result.initial_hpwl) << " -> " << static_cast<long long>(result.solved_hpwl) << ", overflow " << result.solved_overflow << ", " << static_cast<long long>(result.assemble_ms + result.solve_ms) << " ms" << std::endl;
+    }
+
+    if (options.spreading_levels > 0 && !movable.empty()) {
+        start = std::chrono::high_resolution_clock::now();
+        std::vector<double> target_x;
+        std::vector<double> target_y;
+        _spread(target_x, target_y);
+        for (int node : movable) {
+            placement.x[node] = target_x[node] - graph.node_width[node] / 2;
+            placement.y[node] = target_y[node] - graph.node_height[node] / 2;
+        }
+        result.spread_hpwl = result.hpwl = total_hpwl(graph, placement);
+        result.overflow = _overflow();
+        if (options.anchor_weight > 0) {
+            // the pull of a node to its spread position is relative to the weight of its connections
+            std::vector<double> anchor_weight(graph.num_nodes(), 0);
+            for (int node : movable) {
+                anchor_weight[node] = options.anchor_weight * matrix.diagonal[node_variable[node]];
+            }
+            _solve(anchor_weight, target_x, target_y, result);
+            result.hpwl = total_hpwl(graph, placement);
+            result.overflow = _overflow();
+        }
+        end = std::chrono::high_resolution_clock::now();
+        result.spread_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (options.metrics != nullptr) {
+            options.metrics->record_phase("quadratic_spread", start, end);
+        }
+        if (dump) {
+            std::cout << "Spreading: " << options.spreading_levels << " levels, hpwl " << static_cast<long long>(result.spread_hpwl) << ", anchored hpwl " << static_cast<long long>(result.hpwl) << ", overflow " << result.solved_overflow << " -> " << result.overflow << ", " << static_cast<long long>(result.spread_ms) << " ms" << std::endl;
+        }
+    }
+    return result;
+}
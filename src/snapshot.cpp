@@ -0,0 +1,219 @@
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "../include/snapshot.h"
+#include "../include/text_io.h"
+
+namespace {
+
+const char snapshot_magic[8] = {'V', 'L', 'S', 'I', 'H', 'G', 'S', '\0'};
+const uint32_t native_byte_order = 0x01020304;
+
+size_t padded(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+// 64-bit multiply-xor hash over 8 byte words, fast enough to check a GB per second
+uint64_t payload_checksum(const char* data, size_t bytes) {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ bytes;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 29;
+    }
+    uint64_t tail = 0;
+    if (bytes > i) {
+        std::memcpy(&tail, data + i, bytes - i);
+    }
+    hash = (hash ^ tail) * 0xc4ceb9fe1a85ec53ULL;
+    return hash ^ (hash >> 32);
+}
+
+// one payload section: raw bytes of an array
+struct SnapshotSection {
+public:
+    const void* data;
+    size_t bytes;
+};
+
+template <typename T>
+SnapshotSection section_of(const std::vector<T>& array) {
+    return {array.data(), array.size() * sizeof(T)};
+}
+
+// reads the payload sections back in order, checking every section against the payload size
+struct SectionReader {
+public:
+    const char* cur;
+    const char* end;
+    bool failed;
+
+    template <typename T>
+    const T* next(size_t count) {
+        size_t bytes = count * sizeof(T);
+        if (failed || static_cast<size_t>(end - cur) < padded(bytes)) {
+            failed = true;
+            return nullptr;
+        }
+        const T* data = reinterpret_cast<const T*>(cur);
+        cur += padded(bytes);
+        return data;
+    }
+    template <typename T>
+    void next(size_t count, std::vector<T>& array) {
+        const T* data = next<T>(count);
+        if (data != nullptr) {
+            array.assign(data, data + count);
+        }
+    }
+};
+
+} // namespace
+
+std::string default_snapshot_file(const std::string& aux_file_dir) {
+    return aux_file_dir.substr(0, aux_file_dir.find_last_of('.')) + ".hgsnap";
+}
+
+bool snapshot_is_fresh(const std::string& snapshot_file_dir, const std::vector<std::string>& source_file_dirs) {
+    struct stat snapshot_stat;
+    if (stat(snapshot_file_dir.c_str(), &snapshot_stat) != 0) {
+        return false;
+    }
+    for (const auto& source_file_dir : source_file_dirs) {
+        // a source that was deleted or moved makes the snapshot stale, it no longer describes the design
+        struct stat source_stat;
+        if (stat(source_file_dir.c_str(), &source_stat) != 0 || source_stat.st_mtim.tv_sec > snapshot_stat.st_mtim.tv_sec || (source_stat.st_mtim.tv_sec == snapshot_stat.st_mtim.tv_sec && source_stat.st_mtim.tv_nsec >= snapshot_stat.st_mtim.tv_nsec)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool write_hypergraph_snapshot(const Hypergraph& graph, const std::string& snapshot_file_dir, std::string& error) {
+    std::vector<uint8_t> node_type(graph.node_type.size());
+    for (size_t i = 0; i < node_type.size(); i++) {
+        node_type[i] = static_cast<uint8_t>(graph.node_type[i]);
+    }
+    // the order here defines the file layout, see include/snapshot.h
+    std::vector<SnapshotSection> sections = {
+        section_of(graph.node_width), section_of(graph.node_height), section_of(node_type),
+        section_of(graph.node_names.name_offsets()), section_of(graph.node_names.characters()),
+        section_of(graph.net_pin_offsets), section_of(graph.pin_node), section_of(graph.pin_delta_width), section_of(graph.pin_delta_height),
+        section_of(graph.net_names.name_offsets()), section_of(graph.net_names.characters()),
+        section_of(graph.net_node_offsets), section_of(graph.net_nodes), section_of(graph.node_net_offsets), section_of(graph.node_nets)
+    };
+    // the checksum needs the payload in one piece
+    size_t payload_bytes = 0;
+    for (const auto& section : sections) {
+        payload_bytes += padded(section.bytes);
+    }
+    std::vector<char> payload(payload_bytes, 0);
+    size_t offset = 0;
+    for (const auto& section : sections) {
+        if (section.bytes > 0) {
+            std::memcpy(payload.data() + offset, section.data, section.bytes);
+        }
+        offset += padded(section.bytes);
+    }
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.byte_order = native_byte_order;
+    header.num_nodes = static_cast<uint64_t>(graph.num_nodes());
+    header.num_nets = static_cast<uint64_t>(graph.num_nets());
+    header.num_pins = static_cast<uint64_t>(graph.num_pins());
+    header.num_incidences = graph.net_nodes.size();
+    header.node_name_chars = graph.node_names.characters().size();
+    header.net_name_chars = graph.net_names.characters().size();
+    header.payload_bytes = payload_bytes;
+    header.checksum = payload_checksum(payload.data(), payload_bytes);
+
+    // write a temporary file and rename it, a reader never sees a half written snapshot
+    std::string temporary_file_dir = snapshot_file_dir + ".tmp";
+    std::FILE* file = std::fopen(temporary_file_dir.c_str(), "wb");
+    if (file == nullptr) {
+        error = "cannot open file " + temporary_file_dir;
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 && std::fwrite(payload.data(), 1, payload_bytes, file) == payload_bytes;
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(temporary_file_dir.c_str(), snapshot_file_dir.c_str()) != 0) {
+        std::remove(temporary_file_dir.c_str());
+        error = "cannot write file " + snapshot_file_dir;
+        return false;
+    }
+    return true;
+}
+
+bool load_hypergraph_snapshot(const std::string& snapshot_file_dir, Hypergraph& graph, std::string& error) {
+    graph.clear();
+    MappedFile file;
+    if (!file.open(snapshot_file_dir)) {
+        error = "cannot open file " + snapshot_file_dir;
+        return false;
+    }
+    SnapshotHeader header;
+    if (file.size() < sizeof(header)) {
+        error = "truncated snapshot " + snapshot_file_dir;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0) {
+        error = snapshot_file_dir + " is not a hypergraph snapshot";
+        return false;
+    }
+    if (header.version != snapshot_version || header.byte_order != native_byte_order) {
+        error = "snapshot " + snapshot_file_dir + " has version " + std::to_string(header.version) + " or byte order of another machine, expected version " + std::to_string(snapshot_version);
+        return false;
+    }
+    if (file.size() != sizeof(header) + header.payload_bytes) {
+        error = "truncated snapshot " + snapshot_file_dir;
+        return false;
+    }
+    const char* payload = file.data() + sizeof(header);
+    if (payload_checksum(payload, header.payload_bytes) != header.checksum) {
+        error = "checksum mismatch in snapshot " + snapshot_file_dir;
+        return false;
+    }
+
+    SectionReader reader = {payload, payload + header.payload_bytes, false};
+    size_t num_nodes = header.num_nodes;
+    size_t num_nets = header.num_nets;
+    reader.next(num_nodes, graph.node_width);
+    reader.next(num_nodes, graph.node_height);
+    const uint8_t* node_type = reader.next<uint8_t>(num_nodes);
+    const int64_t* node_name_offsets = reader.next<int64_t>(num_nodes + 1);
+    const char* node_name_chars = reader.next<char>(header.node_name_chars);
+    reader.next(num_nets + 1, graph.net_pin_offsets);
+    reader.next(header.num_pins, graph.pin_node);
+    reader.next(header.num_pins, graph.pin_delta_width);
+    reader.next(header.num_pins, graph.pin_delta_height);
+    const int64_t* net_name_offsets = reader.next<int64_t>(num_nets + 1);
+    const char* net_name_chars = reader.next<char>(header.net_name_chars);
+    reader.next(num_nets + 1, graph.net_node_offsets);
+    reader.next(header.num_incidences, graph.net_nodes);
+    reader.next(num_nodes + 1, graph.node_net_offsets);
+    reader.next(header.num_incidences, graph.node_nets);
+    if (reader.failed || reader.cur != reader.end
+        || static_cast<uint64_t>(node_name_offsets[num_nodes]) != header.node_name_chars
+        || static_cast<uint64_t>(net_name_offsets[num_nets]) != header.net_name_chars) {
+        graph.clear();
+        error = "inconsistent section sizes in snapshot " + snapshot_file_dir;
+        return false;
+    }
+    graph.node_names.assign(node_name_chars, node_name_offsets, static_cast<int>(num_nodes));
+    graph.net_names.assign(net_name_chars, net_name_offsets, static_cast<int>(num_nets));
+    graph.node_type.resize(num_nodes);
+    graph.node_size.resize(num_nodes);
+    for (size_t i = 0; i < num_nodes; i++) {
+        graph.node_type[i] = static_cast<NodeTypeEnum>(node_type[i]);
+        graph.node_size[i] = graph.node_width[i] * graph.node_height[i];
+    }
+    return true;
+}
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "../include/sparse.h"
+
+namespace {
+
+// rows of one parallel chunk
+const int row_grain = 4096;
+
+// run body(chunk_begin, chunk_end) on the chunks of [0, end), on the pool if there is one
+void for_chunks(ThreadPool* pool, int end, const std::function<void(int, int)>& body) {
+    if (pool != nullptr) {
+        pool->parallel_for(0, end, row_grain, body);
+        return;
+    }
+    for (int begin = 0; begin < end; begin += row_grain) {
+        body(begin, std::min(end, begin + row_grain));
+    }
+}
+
+// sum of chunk_sums[chunk * stride + offset] over the chunks, in chunk order
+double sum_chunks(const std::vector<double>& chunk_sums, int num_chunks, int stride, int offset) {
+    double sum = 0;
+    for (int chunk = 0; chunk < num_chunks; chunk++) {
+        sum += chunk_sums[static_cast<size_t>(chunk) * stride + offset];
+    }
+    return sum;
+}
+
+// y = A x in the rows of a chunk, returns the sum of x[row] * y[row] over them
+double multiply_rows(const SparseMatrix& a, const double* x, double* y, int begin, int end) {
+    double dot = 0;
+    for (int row = begin; row < end; row++) {
+        double sum = a.diagonal[row] * x[row];
+        for (int entry = a.row_offsets[row]; entry < a.row_offsets[row + 1]; entry++) {
+            sum += a.values[entry] * x[a.columns[entry]];
+        }
+        y[row] = sum;
+        dot += x[row] * sum;
+    }
+    return dot;
+}
+
+}
+
+SparseMatrixBuilder::SparseMatrixBuilder(int num_rows) : num_rows(num_rows), diagonal(num_rows, 0) {}
+
+void SparseMatrixBuilder::add_symmetric(int row, int column, double value) {
+    entry_rows.push_back(row);
+    entry_columns.push_back(column);
+    entry_values.push_back(value);
+    entry_rows.push_back(column);
+    entry_columns.push_back(row);
+    entry_values.push_back(value);
+}
+
+SparseMatrix SparseMatrixBuilder::build(ThreadPool* pool) {
+    SparseMatrix matrix;
+    matrix.num_rows = num_rows;
+    matrix.diagonal = std::move(diagonal);
+    // counting sort by row
+    std::vector<int> offsets(static_cast<size_t>(num_rows) + 1, 0);
+    for (int row : entry_rows) {
+        offsets[row + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<int> columns(entry_rows.size());
+    std::vector<double> values(entry_rows.size());
+    std::vector<int> next(offsets.begin(), offsets.end() - 1);
+    for (size_t entry = 0; entry < entry_rows.size(); entry++) {
+        int slot = next[entry_rows[entry]]++;
+        columns[slot] = entry_columns[entry];
+        values[slot] = entry_values[entry];
+    }
+    std::vector<int>().swap(entry_rows);
+    std::vector<int>().swap(entry_columns);
+    std::vector<double>().swap(entry_values);
+    // sort the columns of every row and merge the duplicates at the front of the row
+    std::vector<int> row_sizes(num_rows, 0);
+    for_chunks(pool, num_rows, [&](int begin, int end) {
+        std::vector<std::pair<int, double> > row_entries;
+        for (int row = begin; row < end; row++) {
+            row_entries.clear();
+            for (int entry = offsets[row]; entry < offsets[row + 1]; entry++) {
+                row_entries.emplace_back(columns[entry], values[entry]);
+            }
+            std::sort(row_entries.begin(), row_entries.end(), [](const std::pair<int, double>& p, const std::pair<int, double>& q) { return p.first < q.first; });
+            int size = 0;
+            for (const auto& row_entry : row_entries) {
+                if (size > 0 && columns[offsets[row] + size - 1] == row_entry.first) {
+                    values[offsets[row] + size - 1] += row_entry.second;
+                    continue;
+                }
+                columns[offsets[row] + size] = row_entry.first;
+                values[offsets[row] + size] = row_entry.second;
+                size++;
+            }
+            row_sizes[row] = size;
+        }
+    });
+    // compact the rows
+    matrix.row_offsets.assign(static_cast<size_t>(num_rows) + 1, 0);
+    for (int row = 0; row < num_rows; row++) {
+        matrix.row_offsets[row + 1] = matrix.row_offsets[row] + row_sizes[row];
+    }
+    matrix.columns.resize(matrix.row_offsets[num_rows]);
+    matrix.values.resize(matrix.row_offsets[num_rows]);
+    for_chunks(pool, num_rows, [&](int begin, int end) {
+        for (int row = begin; row < end; row++) {
+            std::copy(columns.begin() + offsets[row], columns.begin() + offsets[row] + row_sizes[row], matrix.columns.begin() + matrix.row_offsets[row]);
+            std::copy(values.begin() + offsets[row], values.begin() + offsets[row] + row_sizes[row], matrix.values.begin() + matrix.row_offsets[row]);
+        }
+    });
+    return matrix;
+}
+
+ConjugateGradientOptions::ConjugateGradientOptions() : tolerance(1e-6), max_iterations(1000) {}
+
+ConjugateGradientResult conjugate_gradient(const SparseMatrix& a, const std::vector<double>& b, std::vector<double>& x, const ConjugateGradientOptions& options, ThreadPool* pool) {
+    int n = a.num_rows;
+    int num_chunks = (n + row_grain - 1) / row_grain;
+    std::vector<double> r(n);
+    std::vector<double> p(n);
+    std::vector<double> q(n);
+    std::vector<double> inverse_diagonal(n);
+    // up to three sums per chunk, added in chunk order
+    std::vector<double> chunk_sums(3 * static_cast<size_t>(num_chunks), 0);
+    ConjugateGradientResult result;
+    result.iterations = 0;
+    result.relative_residual = 0;
+    result.converged = true;
+
+    // r = b - A x, p = z = r / diagonal
+    for_chunks(pool, n, [&](int begin, int end) {
+        multiply_rows(a, x.data(), q.data(), begin, end);
+        double rz = 0;
+        double bb = 0;
+        double rr = 0;
+        for (int row = begin; row < end; row++) {
+            inverse_diagonal[row] = a.diagonal[row] > 0 ? 1 / a.diagonal[row] : 1;
+            r[row] = b[row] - q[row];
+            p[row] = r[row] * inverse_diagonal[row];
+            rz += r[row] * p[row];
+            bb += b[row] * b[row];
+            rr += r[row] * r[row];
+        }
+        double* sums = chunk_sums.data() + 3 * (begin / row_grain);
+        sums[0] = rz;
+        sums[1] = bb;
+        sums[2] = rr;
+    });
+    double rz = sum_chunks(chunk_sums, num_chunks, 3, 0);
+    double b_norm = std::sqrt(sum_chunks(chunk_sums, num_chunks, 3, 1));
+    if (b_norm == 0) {
+        std::fill(x.begin(), x.end(), 0);
+        return result;
+    }
+    result.relative_residual = std::sqrt(sum_chunks(chunk_sums, num_chunks, 3, 2)) / b_norm;
+    result.converged = result.relative_residual <= options.tolerance;
+    while (!result.converged && result.iterations < options.max_iterations) {
+        // q = A p
+        for_chunks(pool, n, [&](int begin, int end) {
+            chunk_sums[begin / row_grain] = multiply_rows(a, p.data(), q.data(), begin, end);
+        });
+        double pq = sum_chunks(chunk_sums, num_chunks, 1, 0);
+        if (pq <= 0) {
+            break;
+        }
+        double alpha = rz / pq;
+        // x += alpha p, r -= alpha q
+        for_chunks(pool, n, [&](int begin, int end) {
+            for (int row = begin; row < end; row++) {
+                x[row] += alpha * p[row];
+                r[row] -= alpha * q[row];
+            }
+            double rz_chunk = 0;
+            double rr_chunk = 0;
+            for (int row = begin; row < end; row++) {
+                rz_chunk += r[row] * r[row] * inverse_diagonal[row];
+                rr_chunk += r[row] * r[row];
+            }
+            chunk_sums[2 * (begin / row_grain)] = rz_chunk;
+            chunk_sums[2 * (begin / row_grain) + 1] = rr_chunk;
+        });
+        result.iterations++;
+        double rz_next = sum_chunks(chunk_sums, num_chunks, 2, 0);
+        result.relative_residual = std::sqrt(sum_chunks(chunk_sums, num_chunks, 2, 1)) / b_norm;
+        result.converged = result.relative_residual <= options.tolerance;
+        double beta = rz_next / rz;
+        rz = rz_next;
+        // p = z + beta p
+        for_chunks(pool, n, [&](int begin, int end) {
+            for (int row = begin; row < end; row++) {
+                p[row] = r[row] * inverse_diagonal[row] + beta * p[row];
+            }
+        });
+    }
+    return result;
+}
@@ -0,0 +1,130 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../include/text_io.h"
+#include "../include/thread_pool.h"
+
+MappedFile::MappedFile() : mapped_data(nullptr), mapped_size(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& file_dir) {
+    close();
+    int fd = ::open(file_dir.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        return false;
+    }
+    mapped_size = static_cast<size_t>(file_stat.st_size);
+    if (mapped_size == 0) {
+        // mmap refuses empty files, an empty range is fine
+        ::close(fd);
+        mapped_data = "";
+        return true;
+    }
+    void* address = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        mapped_size = 0;
+        return false;
+    }
+    madvise(address, mapped_size, MADV_SEQUENTIAL);
+    mapped_data = static_cast<const char*>(address);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped_data != nullptr && mapped_size > 0) {
+        munmap(const_cast<char*>(mapped_data), mapped_size);
+    }
+    mapped_data = nullptr;
+    mapped_size = 0;
+}
+
+int line_number_of(const char* text_begin, const char* position) {
+    return 1 + static_cast<int>(std::count(text_begin, position, '\n'));
+}
+
+TextWriter::TextWriter() : file(nullptr), buffer_bytes(0), failed(false) {}
+
+TextWriter::~TextWriter() {
+    close();
+}
+
+bool TextWriter::open(const std::string& file_dir, size_t buffer_bytes) {
+    close();
+    file = fopen(file_dir.c_str(), "wb");
+    failed = file == nullptr;
+    this->buffer_bytes = buffer_bytes;
+    buffer.clear();
+    buffer.reserve(buffer_bytes + 256);
+    return file != nullptr;
+}
+
+void TextWriter::flush() {
+    if (file != nullptr && !buffer.empty()) {
+        if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            failed = true;
+        }
+    }
+    buffer.clear();
+}
+
+void TextWriter::write(std::string_view text) {
+    flush();
+    if (file != nullptr && !text.empty()) {
+        if (fwrite(text.data(), 1, text.size(), file) != text.size()) {
+            failed = true;
+        }
+    }
+}
+
+bool TextWriter::close() {
+    if (file == nullptr) {
+        return !failed;
+    }
+    flush();
+    if (fclose(file) != 0) {
+        failed = true;
+    }
+    file = nullptr;
+    return !failed;
+}
+
+void write_parallel(TextWriter& writer, int count, int grain, ThreadPool* pool, const std::function<void(TextBuffer&, int, int)>& format) {
+    grain = std::max(grain, 1);
+    int num_chunks = (count + grain - 1) / grain;
+    // a few chunks per thread keep the threads busy, the buffers of a batch bound the memory
+    int batch_chunks = pool == nullptr ? 1 : 4 * pool->num_threads();
+    std::vector<TextBuffer> buffers(std::min(batch_chunks, std::max(num_chunks, 1)));
+    for (int first_chunk = 0; first_chunk < num_chunks; first_chunk += batch_chunks) {
+        int last_chunk = std::min(first_chunk + batch_chunks, num_chunks);
+        auto format_chunks = [&](int begin, int end) {
+            for (int chunk = begin; chunk < end; chunk++) {
+                TextBuffer& buffer = buffers[chunk - first_chunk];
+                buffer.clear();
+                format(buffer, chunk * grain, std::min(count, (chunk + 1) * grain));
+            }
+        };
+        if (pool == nullptr) {
+            format_chunks(first_chunk, last_chunk);
+        }
+        else {
+            pool->parallel_for(first_chunk, last_chunk, 1, format_chunks);
+        }
+        for (int chunk = first_chunk; chunk < last_chunk; chunk++) {
+            writer.write(buffers[chunk - first_chunk].text);
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+
+#include "../include/thread_pool.h"
+
+namespace {
+// pool and queue index of the current worker thread
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local int current_queue = -1;
+}
+
+ThreadPool::ThreadPool(int num_threads) : stopping(false), queued(0) {
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int t = 0; t <= num_threads; t++) {
+        queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+    }
+    for (int t = 0; t < num_threads; t++) {
+        workers.emplace_back(&ThreadPool::_worker, this, t);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    sleep_condition.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::_self() const {
+    return current_pool == this ? current_queue : num_threads();
+}
+
+bool ThreadPool::_pop(int queue, Task& task, bool from_back) {
+    TaskQueue& q = *queues[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) {
+        return false;
+    }
+    if (from_back) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+    }
+    else {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+    }
+    queued--;
+    return true;
+}
+
+bool ThreadPool::_try_run_one(int self) {
+    Task task;
+    // newest own task first, it is the most likely to be in cache
+    bool found = _pop(self, task, true);
+    // then steal the oldest task of another queue, it is the most likely to be a large one
+    int num_queues = static_cast<int>(queues.size());
+    for (int i = 1; !found && i < num_queues; i++) {
+        found = _pop((self + i) % num_queues, task, false);
+    }
+    if (!found) {
+        return false;
+    }
+    task.run();
+    task.group->pending--;
+    return true;
+}
+
+void ThreadPool::_worker(int self) {
+    current_pool = this;
+    current_queue = self;
+    while (true) {
+        if (_try_run_one(self)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        if (stopping) {
+            return;
+        }
+        // the timeout covers a submit racing with the check of queued
+        sleep_condition.wait_for(lock, std::chrono::milliseconds(10), [this] { return stopping || queued > 0; });
+    }
+}
+
+void ThreadPool::submit(TaskGroup& group, std::function<void()> task) {
+    group.pending++;
+    int self = _self();
+    {
+        TaskQueue& q = *queues[self];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(Task{std::move(task), &group});
+        queued++;
+    }
+    sleep_condition.notify_one();
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+    int self = _self();
+    while (group.pending > 0) {
+        if (!_try_run_one(self)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::parallel_for(int begin, int end, int grain, const std::function<void(int, int)>& body) {
+    if (end <= begin) {
+        return;
+    }
+    grain = std::max(grain, 1);
+    if (grain >= end - begin) {
+        body(begin, end);
+        return;
+    }
+    TaskGroup group;
+    for (int chunk = begin; chunk < end; chunk += grain) {
+        int chunk_end = std::min(end, chunk + grain);
+        submit(group, [&body, chunk, chunk_end] { body(chunk, chunk_end); });
+    }
+    wait(group);
+}
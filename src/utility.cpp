@@ -1,8 +1,8 @@
 #include "../include/utility.h"
 
-BucketNode::BucketNode() : name(""), gain(0), size(0) {}
+BucketNode::BucketNode() : id(-1), gain(0), size(0) {}
 
-BucketNode::BucketNode(std::string name, int gain, double size) : name(name), gain(gain), size(size) {}
+BucketNode::BucketNode(int id, int gain, double size) : id(id), gain(gain), size(size) {}
 
 std::list<BucketNode>::iterator Bucket::_insert_to_bucket(BucketNode node) {
     // check if the gain exists
@@ -44,52 +44,52 @@ void Bucket::_erase_from_bucket(std::list<BucketNode>::iterator iNode) {
 Bucket::Bucket(int max_possible_gain) : max_possible_gain(max_possible_gain) {
     max_gain = -max_possible_gain;
     gain_buckets = std::unordered_map<int, std::list<BucketNode> >();
-    cell_map = std::unordered_map<std::string, std::list<BucketNode>::iterator>();
+    cell_map = std::unordered_map<int, std::list<BucketNode>::iterator>();
 }
 
 void Bucket::insert(BucketNode node) {
-    cell_map[node.name] = _insert_to_bucket(node);
+    cell_map[node.id] = _insert_to_bucket(node);
 }
 
-void Bucket::insert(std::string name, int gain, double size) {
-    cell_map[name] = _insert_to_bucket(BucketNode(name, gain, size));
+void Bucket::insert(int id, int gain, double size) {
+    cell_map[id] = _insert_to_bucket(BucketNode(id, gain, size));
 }
 
-void Bucket::erase(std::string name) {
-    auto it = cell_map[name];
+void Bucket::erase(int id) {
+    auto it = cell_map[id];
     _erase_from_bucket(it);
-    cell_map.erase(name);
+    cell_map.erase(id);
 }
 
-void Bucket::update_gain(std::string name, int new_gain) {
+void Bucket::update_gain(int id, int new_gain) {
     // get the iterator of the node
-    auto it = cell_map[name];
+    auto it = cell_map[id];
     auto new_node = *it;
     new_node.gain = new_gain;
     // erase the node from the bucket
     _erase_from_bucket(it);
     // insert the new node to the bucket and update the cell_map
-    cell_map[name] = _insert_to_bucket(new_node);
+    cell_map[id] = _insert_to_bucket(new_node);
 }
 
-void Bucket::increase_gain(std::string name) {
-    auto it = cell_map[name];
+void Bucket::increase_gain(int id) {
+    auto it = cell_map[id];
     auto new_node = *it;
     new_node.gain++;
     // erase the node from the bucket
     _erase_from_bucket(it);
     // insert the new node to the bucket and update the cell_map
-    cell_map[name] = _insert_to_bucket(new_node);
+    cell_map[id] = _insert_to_bucket(new_node);
 }
 
-void Bucket::decrease_gain(std::string name) {
-    auto it = cell_map[name];
+void Bucket::decrease_gain(int id) {
+    auto it = cell_map[id];
     auto new_node = *it;
     new_node.gain--;
     // erase the node from the bucket
     _erase_from_bucket(it);
     // insert the new node to the bucket and update the cell_map
-    cell_map[name] = _insert_to_bucket(new_node);
+    cell_map[id] = _insert_to_bucket(new_node);
 }
 
 bool Bucket::is_empty() const {
@@ -109,7 +109,38 @@ void Bucket::dump() const {
     for (const auto& pair : gain_buckets) {
         std::cout << "Gain: " << pair.first << " -> ";
         for (const auto& node : pair.second) {
-            std::cout << "(" << node.name << ", " << node.gain << ", " << node.size << ") ";
+            std::cout << "(" << node.id << ", " << node.gain << ", " << node.size << ") ";
+        }
+        std::cout << std::endl;
+    }
+}
+
+BucketArray::BucketArray() : max_index(0), num_entries(0), max_possible_gain(0) {}
+
+BucketArray::BucketArray(int maximum_possible_gain, int num_ids) : BucketArray() {
+    reset(maximum_possible_gain, num_ids);
+}
+
+void BucketArray::reset(int maximum_possible_gain, int num_ids) {
+    max_possible_gain = maximum_possible_gain;
+    heads.assign(2 * static_cast<size_t>(max_possible_gain) + 1, -1);
+    next.assign(num_ids, -1);
+    prev.assign(num_ids, -1);
+    gains.assign(num_ids, 0);
+    in_bucket.assign(num_ids, false);
+    max_index = 0;
+    num_entries = 0;
+}
+
+void BucketArray::dump() const {
+    std::cout << "Bucket dump:" << std::endl;
+    for (int index = static_cast<int>(heads.size()) - 1; index >= 0; index--) {
+        if (heads[index] < 0) {
+            continue;
+        }
+        std::cout << "Gain: " << index - max_possible_gain << " -> ";
+        for (int id = heads[index]; id >= 0; id = next[id]) {
+            std::cout << "(" << id << ", " << gains[id] << ") ";
         }
         std::cout << std::endl;
     }
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "../include/wirelength.h"
+
+namespace {
+
+// nets of one evaluation chunk
+const int net_grain = 4096;
+
+// pins of one coordinate gathering chunk
+const int pin_grain = 65536;
+
+// max - min of x plus max - min of y over n > 0 pins
+inline double box_hpwl(const double* x, const double* y, int n) {
+    int i = 0;
+    double x_min = x[0];
+    double x_max = x[0];
+    double y_min = y[0];
+    double y_max = y[0];
+#if defined(__AVX__)
+    if (n >= 8) {
+        __m256d x_low = _mm256_loadu_pd(x);
+        __m256d x_high = x_low;
+        __m256d y_low = _mm256_loadu_pd(y);
+        __m256d y_high = y_low;
+        for (i = 4; i + 4 <= n; i += 4) {
+            __m256d xs = _mm256_loadu_pd(x + i);
+            __m256d ys = _mm256_loadu_pd(y + i);
+            x_low = _mm256_min_pd(x_low, xs);
+            x_high = _mm256_max_pd(x_high, xs);
+            y_low = _mm256_min_pd(y_low, ys);
+            y_high = _mm256_max_pd(y_high, ys);
+        }
+        double lanes[4][4];
+        _mm256_storeu_pd(lanes[0], x_low);
+        _mm256_storeu_pd(lanes[1], x_high);
+        _mm256_storeu_pd(lanes[2], y_low);
+        _mm256_storeu_pd(lanes[3], y_high);
+        for (int lane = 0; lane < 4; lane++) {
+            x_min = std::min(x_min, lanes[0][lane]);
+            x_max = std::max(x_max, lanes[1][lane]);
+            y_min = std::min(y_min, lanes[2][lane]);
+            y_max = std::max(y_max, lanes[3][lane]);
+        }
+    }
+#elif defined(__SSE2__)
+    if (n >= 4) {
+        __m128d x_low = _mm_loadu_pd(x);
+        __m128d x_high = x_low;
+        __m128d y_low = _mm_loadu_pd(y);
+        __m128d y_high = y_low;
+        for (i = 2; i + 2 <= n; i += 2) {
+            __m128d xs = _mm_loadu_pd(x + i);
+            __m128d ys = _mm_loadu_pd(y + i);
+            x_low = _mm_min_pd(x_low, xs);
+            x_high = _mm_max_pd(x_high, xs);
+            y_low = _mm_min_pd(y_low, ys);
+            y_high = _mm_max_pd(y_high, ys);
+        }
+        double lanes[4][2];
+        _mm_storeu_pd(lanes[0], x_low);
+        _mm_storeu_pd(lanes[1], x_high);
+        _mm_storeu_pd(lanes[2], y_low);
+        _mm_storeu_pd(lanes[3], y_high);
+        for (int lane = 0; lane < 2; lane++) {
+            x_min = std::min(x_min, lanes[0][lane]);
+            x_max = std::max(x_max, lanes[1][lane]);
+            y_min = std::min(y_min, lanes[2][lane]);
+            y_max = std::max(y_max, lanes[3][lane]);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        x_min = std::min(x_min, x[i]);
+        x_max = std::max(x_max, x[i]);
+        y_min = std::min(y_min, y[i]);
+        y_max = std::max(y_max, y[i]);
+    }
+    return (x_max - x_min) + (y_max - y_min);
+}
+
+}
+
+HpwlEvaluator::HpwlEvaluator(const Hypergraph& graph, int num_threads) : graph(graph) {
+    if (num_threads != 1) {
+        pool = std::make_unique<ThreadPool>(num_threads);
+    }
+    int num_pins = static_cast<int>(graph.pin_node.size());
+    pin_offset_x.resize(num_pins);
+    pin_offset_y.resize(num_pins);
+    pin_x.assign(num_pins, 0);
+    pin_y.assign(num_pins, 0);
+    _parallel_for(0, num_pins, pin_grain, [&](int begin, int end) {
+        for (int pin = begin; pin < end; pin++) {
+            int node = graph.pin_node[pin];
+            pin_offset_x[pin] = graph.node_width[node] / 2 + graph.pin_delta_width[pin];
+            pin_offset_y[pin] = graph.node_height[node] / 2 + graph.pin_delta_height[pin];
+        }
+    });
+}
+
+void HpwlEvaluator::_parallel_for(int begin, int end, int grain, const std::function<void(int, int)>& body) const {
+    if (pool != nullptr) {
+        pool->parallel_for(begin, end, grain, body);
+        return;
+    }
+    for (int chunk_begin = begin; chunk_begin < end; chunk_begin += grain) {
+        body(chunk_begin, std::min(end, chunk_begin + grain));
+    }
+}
+
+void HpwlEvaluator::set_placement(const Placement& placement) {
+    _parallel_for(0, static_cast<int>(pin_x.size()), pin_grain, [&](int begin, int end) {
+        for (int pin = begin; pin < end; pin++) {
+            int node = graph.pin_node[pin];
+            pin_x[pin] = placement.x[node] + pin_offset_x[pin];
+            pin_y[pin] = placement.y[node] + pin_offset_y[pin];
+        }
+    });
+}
+
+double HpwlEvaluator::net_hpwl(int net) const {
+    int first = graph.net_pin_offsets[net];
+    int num_pins = graph.net_pin_offsets[net + 1] - first;
+    return num_pins < 2 ? 0 : box_hpwl(pin_x.data() + first, pin_y.data() + first, num_pins);
+}
+
+double HpwlEvaluator::total() const {
+    return report().total;
+}
+
+WirelengthReport HpwlEvaluator::report(const std::vector<int>* partition, int num_parts) const {
+    auto start = std::chrono::high_resolution_clock::now();
+    int num_nets = graph.num_nets();
+    int num_chunks = (num_nets + net_grain - 1) / net_grain;
+    if (partition == nullptr) {
+        num_parts = 0;
+    }
+    // sums of every chunk: total, cut and the parts, added in chunk order below
+    int stride = num_parts + 2;
+    std::vector<double> chunk_sums(static_cast<size_t>(num_chunks) * stride, 0);
+    std::vector<int> chunk_cut_nets(num_chunks, 0);
+    _parallel_for(0, num_nets, net_grain, [&](int begin, int end) {
+        int chunk = begin / net_grain;
+        double* sums = chunk_sums.data() + static_cast<size_t>(chunk) * stride;
+        for (int net = begin; net < end; net++) {
+            double hpwl = net_hpwl(net);
+            sums[0] += hpwl;
+            if (partition == nullptr || graph.net_pin_offsets[net] == graph.net_pin_offsets[net + 1]) {
+                continue;
+            }
+            IdRange nodes = graph.nodes_of(net);
+            int part = (*partition)[*nodes.begin()];
+            bool is_cut = false;
+            for (int node : nodes) {
+                if ((*partition)[node] != part) {
+                    is_cut = true;
+                    break;
+                }
+            }
+            if (is_cut) {
+                sums[1] += hpwl;
+                chunk_cut_nets[chunk]++;
+            }
+            else {
+                sums[2 + part] += hpwl;
+            }
+        }
+    });
+    WirelengthReport report;
+    report.total = 0;
+    report.cut = 0;
+    report.num_cut_nets = 0;
+    report.parts.assign(num_parts, 0);
+    for (int chunk = 0; chunk < num_chunks; chunk++) {
+        const double* sums = chunk_sums.data() + static_cast<size_t>(chunk) * stride;
+        report.total += sums[0];
+        report.cut += sums[1];
+        report.num_cut_nets += chunk_cut_nets[chunk];
+        for (int part = 0; part < num_parts; part++) {
+            report.parts[part] += sums[2 + part];
+        }
+    }
+    report.evaluate_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/generator.h"
+#include "../include/kway.h"
+
+// ## checks of the k-way refinement with fixed terminals: every terminal keeps the part the recursive bisection gave it,
+// the refinement never increases the connectivity, and the parts stay within the imbalance
+// exit code 1 if a check fails
+
+bool check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+    }
+    return condition;
+}
+
+bool test_design(int num_nodes, int num_parts, bool multilevel) {
+    GeneratorOptions generator_options;
+    generator_options.num_nodes = num_nodes;
+    generator_options.num_nets = num_nodes;
+    Hypergraph graph = generate_hypergraph(generator_options);
+    std::string name = std::to_string(num_nodes) + " nodes, " + std::to_string(num_parts) + " parts" + (multilevel ? ", multilevel" : "");
+
+    KWayOptions options;
+    options.num_parts = num_parts;
+    options.multilevel = multilevel;
+    options.bisection.fm.area_constraint = 0;
+    options.bisection.fm.dump_level = -1;
+    options.bisection.fm.fix_terminals = true;
+    // the bisections only depend on the seed, so the unrefined result is the partition the refinement starts from
+    options.refine = false;
+    KWayResult bisected = recursive_bisection(graph, options);
+    options.refine = true;
+    KWayResult refined = recursive_bisection(graph, options);
+    std::cout << name << ": connectivity " << bisected.connectivity << " -> " << refined.connectivity << std::endl;
+
+    int num_terminals = 0;
+    bool passed = true;
+    for (int node = 0; node < graph.num_nodes(); node++) {
+        if (graph.node_type[node] == NodeTypeEnum::node) {
+            continue;
+        }
+        num_terminals++;
+        if (refined.part[node] != bisected.part[node]) {
+            passed = check(false, name + ": terminal " + std::string(graph.node_names[node]) + " moved from part " + std::to_string(bisected.part[node]) + " to " + std::to_string(refined.part[node]));
+            break;
+        }
+    }
+    passed &= check(num_terminals > 0, name + ": the design has terminals");
+    passed &= check(refined.connectivity <= bisected.connectivity, name + ": the refinement does not increase the connectivity");
+    passed &= check(refined.imbalance <= options.imbalance + 1e-9, name + ": the parts are balanced");
+    return passed;
+}
+
+int main() {
+    bool passed = test_design(20000, 4, false);
+    passed &= test_design(20000, 7, true);
+    return passed ? 0 : 1;
+}